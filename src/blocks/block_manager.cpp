@@ -369,3 +369,32 @@ Texture2D BlockManager::GenGlowstoneTexture(int size)
     SetTextureFilter(tex, TEXTURE_FILTER_POINT);
     return tex;
 }
+
+Texture2D BlockManager::GenWaterTexture(int size)
+{
+    Image img = GenImagePerlinNoise(size, size, 0, 0, 4.0f);
+    Color* pixels = LoadImageColors(img);
+
+    Color deep    = { 30, 70, 160, 170 };
+    Color shallow = { 60, 120, 210, 170 };
+
+    for (int i = 0; i < size * size; i++)
+    {
+        float v = pixels[i].r / 255.0f;
+        Color c = LerpColor(deep, shallow, v);
+
+        // occasional highlight ripple
+        if (GetRandomValue(0, 30) == 0)
+            c = { 140, 190, 240, 190 };
+
+        pixels[i] = c;
+    }
+
+    UnloadImage(img);
+    Image finalImg = { pixels, size, size, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+    Texture2D tex = LoadTextureFromImage(finalImg);
+    UnloadImageColors(pixels);
+
+    SetTextureFilter(tex, TEXTURE_FILTER_POINT);
+    return tex;
+}
@@ -24,6 +24,7 @@ public:
     static Texture2D GenSnowLeavesSideTexture(int size);
     static Texture2D GenTorchTexture(int size);
     static Texture2D GenGlowstoneTexture(int size);
+    static Texture2D GenWaterTexture(int size);
 };
 
 #endif
\ No newline at end of file
@@ -23,14 +23,38 @@ enum class BlockType : uint8_t {
     SNOW_LEAVES = 12,
     TORCH = 13,    
     GLOWSTONE = 14,
+    WATER = 15,
 
     COUNT
 };
 
+/**
+ * true if the block stops light (air, foliage and light sources let it through)
+ */
+inline bool IsOpaque(BlockType type) {
+    return type != BlockType::AIR && type != BlockType::LEAVES && type != BlockType::SNOW_LEAVES &&
+           type != BlockType::TORCH && type != BlockType::GLOWSTONE && type != BlockType::WATER;
+}
+
+/**
+ * true if the block stops direct sunlight (opaque blocks and water, which dims
+ * it with depth instead of letting it straight through)
+ */
+inline bool BlocksSunlight(BlockType type) {
+    return IsOpaque(type) || type == BlockType::WATER;
+}
+
+/**
+ * true if the player and falling blocks can't pass through it
+ */
+inline bool IsSolid(BlockType type) {
+    return type != BlockType::AIR && type != BlockType::WATER;
+}
+
 /**
  * defines available biomes for world generation
  */
-enum class BiomeType { 
+enum class BiomeType : uint8_t { 
     FOREST, 
     DESERT, 
     SNOW 
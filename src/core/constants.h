@@ -5,9 +5,28 @@
 #define CHUNK_SIZE 64
 #define SEA_LEVEL 28
 
+// water levels: sources are full, falling water is one below
+#define WATER_SOURCE_LEVEL 8
+#define WATER_FALLING_LEVEL 7
+
+// physics ticks (20 per second) per water step
+#define FLUID_TICK_INTERVAL 4
+
+// .vxl format version written by SaveMap (2 adds water levels, 3 the
+// terrain version)
+#define SAVE_VERSION 3
+
+// terrain generation version (2 lowers the plains so lakes form). a world
+// keeps the version it was created with, so new chunks match saved ones
+#define TERRAIN_VERSION 2
+
 // render settings (modified by main)
 extern int RENDER_DISTANCE;
 
+// memory for chunk data in MB: what the chunks around the player leave of
+// it holds compressed chunks further out (modified by main)
+extern int CHUNK_MEMORY_MB;
+
 // texture atlas settings
 #define BLOCK_TEX_SIZE 16
 
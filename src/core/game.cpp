@@ -1,5 +1,8 @@
 #include "game.h"
 #include "../world/world_generator.h"
+#include "profiler.h"
+#include "job_system.h"
+#include "save_file.h"
 #include <fstream>
 #include <cstring>
 
@@ -19,7 +22,8 @@ void Game::Init() {
 	messageTimer = 0.0f;
 	messageText = "";
 	physicsTimer = 0.0f;
-
+	stepAccumulator = 0.0f;
+	pendingInput = {};
 
 	DisableCursor();
 	HideCursor();
@@ -27,8 +31,14 @@ void Game::Init() {
 	// start in Menu
 	currentState = STATE_MENU;
 
+	loadingProgress = 0;
+	loadNext = 0;
+	loadStartCount = 0;
+	loadStartReady = 0;
+
 	// init auto-save
 	autoSaveTimer = 0.0f;
+	telemetryTimer = 0.0f;
 
 	// other defaults
 	strcpy(worldNameBuffer, "New World");
@@ -66,12 +76,11 @@ void Game::Update() {
 		break;
 
 	case STATE_PLAYING:
+	{
+		bool fixedStep = recorder.IsRecording() || replay.IsPlaying();
 
-		physicsTimer += GetFrameTime();
-		if (physicsTimer >= 0.05f) {
-			physicsTimer -= 0.05f;
-			world.UpdateChunkPhysics();
-		}
+		// fixed-step runs tick physics with the player instead
+		if (!fixedStep) UpdatePhysics(GetFrameTime());
 
 		// time of day logic
 		if (timeMode == 0) { // cycle
@@ -97,6 +106,8 @@ void Game::Update() {
 			DisableCursor();
 		}
 
+		if (IsKeyPressed(KEY_F9) && !replay.IsPlaying()) ToggleRecording();
+
 		if (showDebugUI) {
 			// menu mode
 		}
@@ -104,9 +115,42 @@ void Game::Update() {
 			if (IsKeyPressed(KEY_P)) SaveMap(currentSaveName.c_str());
 			if (IsKeyPressed(KEY_L)) LoadMap(currentSaveName.c_str());
 
-			player.Update(GetFrameTime(), world);
-			player.UpdateRaycast(world);
-			player.HandleInput(world);
+			InputFrame live = PollInput();
+			if (!fixedStep) {
+				StepPlayer(GetFrameTime(), live);
+			}
+			else {
+				// frames are gathered into fixed ticks so a replay steps exactly like the recording
+				MergeInput(pendingInput, live);
+				stepAccumulator += GetFrameTime();
+
+				int ticks = 0;
+				while (stepAccumulator >= REPLAY_TIMESTEP && ticks < MAX_STEPS_PER_FRAME) {
+					stepAccumulator -= REPLAY_TIMESTEP;
+					ticks++;
+
+					InputFrame input = pendingInput;
+					pendingInput = {};
+					pendingInput.held = input.held;
+
+					if (replay.IsPlaying()) {
+						if (!replay.Next(input)) {
+							messageText = "REPLAY FINISHED";
+							messageTimer = 3.0f;
+							break;
+						}
+					}
+					else {
+						recorder.Record(input);
+					}
+
+					UpdatePhysics(REPLAY_TIMESTEP);
+					StepPlayer(REPLAY_TIMESTEP, input);
+				}
+
+				// don't try to catch up after a long hitch
+				if (ticks == MAX_STEPS_PER_FRAME) stepAccumulator = 0.0f;
+			}
 		}
 
 		if (IsKeyPressed(KEY_P)) SaveMap(currentSaveName.c_str()); // manual Save
@@ -120,6 +164,13 @@ void Game::Update() {
 			messageTimer = 2.0f;
 		}
 
+		// streaming telemetry (every 5 seconds)
+		telemetryTimer += GetFrameTime();
+		if (telemetryTimer > 5.0f) {
+			telemetryTimer = 0.0f;
+			DumpTelemetry();
+		}
+
 		if (IsKeyPressed(KEY_ESCAPE)) {
 			EnableCursor(); // unlock mouse so we can click buttons
 			currentState = STATE_PAUSE;
@@ -127,6 +178,85 @@ void Game::Update() {
 
 		break;
 	}
+	}
+}
+
+/**
+ * advances falling blocks, water and block ticks at a fixed 20 ticks per second
+ */
+void Game::UpdatePhysics(float dt) {
+	physicsTimer += dt;
+	if (physicsTimer >= 0.05f) {
+		physicsTimer -= 0.05f;
+		world.UpdateChunkPhysics();
+		world.UpdateFluids();
+		world.UpdateBlockTicks();
+	}
+}
+
+void Game::StepPlayer(float dt, const InputFrame& input) {
+	player.Update(dt, world, input);
+	player.UpdateRaycast(world);
+	player.HandleInput(world, input);
+}
+
+/**
+ * F9: starts or stops writing replays/flight.rpl
+ * replays start from a freshly generated world, so edits made before
+ * recording started are not part of it
+ */
+void Game::ToggleRecording() {
+	if (recorder.IsRecording()) {
+		recorder.Stop();
+		messageText = "REPLAY SAVED";
+		messageTimer = 3.0f;
+		return;
+	}
+
+	if (!DirectoryExists("replays")) MakeDirectory("replays");
+
+	ReplayHeader header = {};
+	header.seed = WorldGenerator::worldSeed;
+	header.position = player.position;
+	header.cameraAngleX = player.cameraAngleX;
+	header.cameraAngleY = player.cameraAngleY;
+	header.isFlying = player.isFlying;
+
+	if (recorder.Start("replays/flight.rpl", header)) {
+		stepAccumulator = 0.0f;
+		player.physicsAccumulator = 0.0f; // the replay starts on a step boundary too
+		pendingInput = {};
+		messageText = "RECORDING (F9 TO STOP)";
+	}
+	else {
+		messageText = "FAILED TO START RECORDING";
+	}
+	messageTimer = 3.0f;
+}
+
+bool Game::StartReplay(const char* path) {
+	if (!replay.Open(path)) return false;
+
+	const ReplayHeader& header = replay.GetHeader();
+	world.UnloadAll();
+	WorldGenerator::worldSeed = header.seed;
+	WorldGenerator::terrainVersion = TERRAIN_VERSION;
+	player.Init();
+	player.position = header.position;
+	player.cameraAngleX = header.cameraAngleX;
+	player.cameraAngleY = header.cameraAngleY;
+	player.isFlying = header.isFlying;
+
+	// never overwrite a real world with whatever the replay does
+	currentSaveName = "replay.vxl";
+	isNewGame = false;
+	stepAccumulator = 0.0f;
+	physicsTimer = 0.0f;
+	pendingInput = {};
+
+	currentState = STATE_LOADING;
+	loadingProgress = 0;
+	return true;
 }
 
 /**
@@ -138,7 +268,7 @@ void Game::Draw() {
 		renderer.DrawScene(player, world, timeOfDay);
 		renderer.DrawUI(player, GetScreenWidth(), GetScreenHeight(), messageText, messageTimer);
 		if (showDebugUI) {
-			renderer.DrawDebug(player, daySpeed, timeMode);
+			renderer.DrawDebug(player, world.GetStats(), daySpeed, timeMode);
 		}
 		EndDrawing();
 	}
@@ -180,9 +310,12 @@ void Game::Draw() {
 void Game::ShutDown() {
 	renderer.Unload();
 	world.UnloadAll();
+	JobSystem::Shutdown();
 }
 
 void Game::SaveMap(const char* filename) {
+	PROFILE_SCOPE(ProfileZone::SAVE);
+
 	// Open file in Binary Mode
 	if (!DirectoryExists("worlds")) MakeDirectory("worlds");
 
@@ -196,21 +329,15 @@ void Game::SaveMap(const char* filename) {
 		return;
 	}
 
-	// HEADER (Magic Number + Version)
-	const char* magic = "VOXL";
-	int version = 1;
-	out.write(magic, 4);
-	out.write((char*)&version, sizeof(int));
-
-	// WORLD GLOBAL DATA
-	out.write((char*)&WorldGenerator::worldSeed, sizeof(int));
-
-	// PLAYER DATA (Position, Camera, Inventory)
-	// Since Inventory is a simple struct (POD), we can write it directly
-	out.write((char*)&player.position, sizeof(Vector3));
-	out.write((char*)&player.cameraAngleX, sizeof(float));
-	out.write((char*)&player.cameraAngleY, sizeof(float));
-	out.write((char*)&player.inventory, sizeof(Inventory));
+	// HEADER (Magic Number + Version, Seed, Player)
+	SaveHeader header;
+	header.seed = WorldGenerator::worldSeed;
+	header.terrain = WorldGenerator::terrainVersion;
+	header.position = player.position;
+	header.cameraAngleX = player.cameraAngleX;
+	header.cameraAngleY = player.cameraAngleY;
+	header.inventory = player.inventory;
+	WriteSaveHeader(out, header);
 
 	// CHUNK DATA
 	world.SaveChunks(out);
@@ -220,6 +347,31 @@ void Game::SaveMap(const char* filename) {
 	messageTimer = 2.0f;
 }
 
+/**
+ * appends one row of chunk streaming stats to telemetry/chunk_stats.csv
+ */
+void Game::DumpTelemetry() {
+	if (!DirectoryExists("telemetry")) MakeDirectory("telemetry");
+
+	const char* path = "telemetry/chunk_stats.csv";
+	bool writeHeader = !FileExists(path);
+
+	std::ofstream out(path, std::ios::app);
+	if (!out) return;
+
+	if (writeHeader) {
+		out << "time_s,render_distance,fps,resident,pending_generate,pending_mesh,dirty,"
+			<< "cpu_bytes,gpu_bytes,latency_count,latency_avg_ms,latency_p50_ms,latency_p95_ms\n";
+	}
+
+	const ChunkStats& stats = world.GetStats();
+	double avg = stats.latencyCount > 0 ? stats.latencyTotalMs / stats.latencyCount : 0.0;
+	out << GetTime() << "," << RENDER_DISTANCE << "," << GetFPS() << ","
+		<< stats.resident << "," << stats.pendingGenerate << "," << stats.pendingMesh << "," << stats.dirty << ","
+		<< stats.cpuBytes << "," << stats.gpuBytes << ","
+		<< stats.latencyCount << "," << avg << "," << stats.LatencyPercentile(0.5f) << "," << stats.LatencyPercentile(0.95f) << "\n";
+}
+
 /**
  * loads world data from binary file
  */
@@ -238,25 +390,23 @@ bool Game::LoadMap(const char* filename) {
 	}
 
 	// HEADER CHECK
-	char magic[5] = { 0 };
-	in.read(magic, 4);
-	if (strcmp(magic, "VOXL") != 0) {
-		messageText = "INVALID SAVE FILE";
+	SaveHeader header;
+	const char* error = ReadSaveHeader(in, header);
+	if (error) {
+		messageText = error;
 		messageTimer = 3.0f;
 		return false;
 	}
 
-	int version;
-	in.read((char*)&version, sizeof(int));
-
 	// WORLD GLOBAL DATA
-	in.read((char*)&WorldGenerator::worldSeed, sizeof(int));
+	WorldGenerator::worldSeed = header.seed;
+	WorldGenerator::terrainVersion = header.terrain;
 
 	// PLAYER DATA
-	in.read((char*)&player.position, sizeof(Vector3));
-	in.read((char*)&player.cameraAngleX, sizeof(float));
-	in.read((char*)&player.cameraAngleY, sizeof(float));
-	in.read((char*)&player.inventory, sizeof(Inventory));
+	player.position = header.position;
+	player.cameraAngleX = header.cameraAngleX;
+	player.cameraAngleY = header.cameraAngleY;
+	player.inventory = header.inventory;
 
 	// Recalculate vectors
 	player.forward = { sinf(player.cameraAngleX), 0.0f, cosf(player.cameraAngleX) };
@@ -264,7 +414,7 @@ bool Game::LoadMap(const char* filename) {
 
 	// CHUNK DATA
 	// This reads the blocks but DOES NOT build the meshes yet (fast!)
-	world.LoadChunks(in);
+	world.LoadChunks(in, header.version);
 
 	in.close();
 	messageText = "GAME LOADED!";
@@ -307,6 +457,7 @@ void Game::DrawMenu() {
 	if (GuiButton({ (float)cx - 300, 380, 260, 40 }, "CREATE WORLD")) {
 		world.UnloadAll();
 		WorldGenerator::worldSeed = atoi(seedBuffer);
+		WorldGenerator::terrainVersion = TERRAIN_VERSION;
 		player.Init();
 		isNewGame = true;
 
@@ -356,60 +507,118 @@ void Game::DrawMenu() {
 }
 
 /**
- * handles partial chunk loading during loading screen
+ * true if the chunk is one the player sees right away: the 3x3 around them,
+ * or any corner of it inside the horizontal field of view
  */
-void Game::UpdateLoading() {
-	// Goal: Pre-load the chunks around the player before starting.
-	int loadRadius = 6;
-	static int currentX = -loadRadius;
-	static int currentZ = -loadRadius;
+static bool IsChunkInView(int cx, int cz, const Camera3D& camera, float cosHalfFov) {
+	int px = (int)floor(camera.position.x / CHUNK_SIZE);
+	int pz = (int)floor(camera.position.z / CHUNK_SIZE);
+	if (abs(cx - px) <= 1 && abs(cz - pz) <= 1) return true;
+
+	Vector3 forward = { camera.target.x - camera.position.x, 0.0f, camera.target.z - camera.position.z };
+	float length = sqrtf(forward.x * forward.x + forward.z * forward.z);
+	if (length == 0.0f) return true;
+
+	for (int corner = 0; corner < 4; corner++) {
+		float dx = (cx + (corner & 1)) * CHUNK_SIZE - camera.position.x;
+		float dz = (cz + (corner >> 1)) * CHUNK_SIZE - camera.position.z;
+		float distance = sqrtf(dx * dx + dz * dz);
+		if (distance > 0.0f && (dx * forward.x + dz * forward.z) / (distance * length) >= cosHalfFov) return true;
+	}
+	return false;
+}
 
+/**
+ * preloads the chunks streaming wants around the player, a batch per frame
+ * spread over the job system. play starts as soon as everything near and
+ * in view is meshed, the rest keeps streaming in while playing
+ */
+void Game::UpdateLoading() {
 	// RESET LOOP (Start Condition)
+	// nearest first, same order the streaming uses
 	if (loadingProgress == 0) {
-		currentX = -loadRadius;
-		currentZ = -loadRadius;
+		ChunkManager::RankOffsets(RENDER_DISTANCE + 1, { 0, 0, 0 }, loadOrder);
+		loadNext = 0;
 		loadingProgress = 1;
 	}
 
-	// generate specific chunk
+	if (IsKeyPressed(KEY_ESCAPE)) {
+		CancelLoading();
+		return;
+	}
+
 	int px = (int)floor(player.position.x / CHUNK_SIZE);
 	int pz = (int)floor(player.position.z / CHUNK_SIZE);
 
-	int cx = px + currentX;
-	int cz = pz + currentZ;
-
-	// Force Generation
-	world.GetBlock(cx * CHUNK_SIZE, 0, cz * CHUNK_SIZE);
+	// one batch a frame keeps the bar moving and every core busy
+	int batchSize = LOAD_BATCH_PER_THREAD * (JobSystem::GetWorkerCount() + 1);
+	std::vector<ChunkCoord> batch;
+	for (; loadNext < (int)loadOrder.size() && (int)batch.size() < batchSize; loadNext++) {
+		batch.push_back({ px + loadOrder[loadNext].x, pz + loadOrder[loadNext].z });
+	}
+	world.GenerateBatch(batch);
 
-	// need the textures to build the mesh
+	// the new chunks may complete the neighbours of any chunk around them
+	// (RebuildMesh skips the ones still waiting)
 	Texture2D* tex = renderer.GetTextures();
-	world.RebuildMesh(cx, cz, tex);
+	for (const ChunkCoord& coord : batch) {
+		for (int nx = coord.x - 1; nx <= coord.x + 1; nx++) {
+			for (int nz = coord.z - 1; nz <= coord.z + 1; nz++) {
+				world.RebuildMesh(nx, nz, tex);
+			}
+		}
+	}
 
-	// move to next chunk
-	currentZ++;
-	if (currentZ > loadRadius) {
-		currentZ = -loadRadius;
-		currentX++;
+	// horizontal half angle of the view, from the vertical fov and the aspect ratio
+	float aspect = GetScreenHeight() > 0 ? (float)GetScreenWidth() / GetScreenHeight() : 1.0f;
+	float halfFov = atanf(tanf(player.camera.fovy * 0.5f * DEG2RAD) * aspect);
+
+	// the camera only gets placed by the first player update
+	Camera3D view = player.camera;
+	view.position = player.position;
+	view.target = { player.position.x + sinf(player.cameraAngleX), player.position.y, player.position.z + cosf(player.cameraAngleX) };
+
+	int startRadius = MIN(LOAD_START_RADIUS, RENDER_DISTANCE);
+	loadStartCount = 0;
+	loadStartReady = 0;
+	for (int dx = -startRadius; dx <= startRadius; dx++) {
+		for (int dz = -startRadius; dz <= startRadius; dz++) {
+			if (!IsChunkInView(px + dx, pz + dz, view, cosf(halfFov))) continue;
+			loadStartCount++;
+			const Chunk* chunk = world.FindChunk(px + dx, pz + dz);
+			if (chunk && chunk->state == ChunkState::MESHED) loadStartReady++;
+		}
 	}
 
 	// calculate Progress %
-	int totalChunks = (loadRadius * 2 + 1) * (loadRadius * 2 + 1);
-	int chunksDone = (currentX + loadRadius) * (loadRadius * 2 + 1) + (currentZ + loadRadius);
-
-	loadingProgress = (int)((float)chunksDone / (float)totalChunks * 100.0f);
+	loadingProgress = (int)((float)loadStartReady / (float)loadStartCount * 100.0f);
 
 	// FIX: Prevent infinite loop
 	// If the math returns 0, force it to 1 so the reset logic doesn't trigger again.
 	if (loadingProgress == 0) loadingProgress = 1;
 
 	// FINISHED?
-	if (currentX > loadRadius) {
+	if (loadStartReady == loadStartCount) {
+		// new worlds start on the generated surface
+		if (isNewGame) player.PlaceOnSurface(world);
+
 		currentState = STATE_PLAYING;
 		loadingProgress = 0; // Reset for next time
 		DisableCursor();
 	}
 }
 
+/**
+ * back to the menu, dropping whatever was loaded so far
+ */
+void Game::CancelLoading() {
+	if (replay.IsPlaying()) replay.Close();
+	world.UnloadAll();
+	loadingProgress = 0;
+	currentState = STATE_MENU;
+	EnableCursor();
+}
+
 void Game::DrawLoading() {
 	BeginDrawing();
 	ClearBackground(BLACK);
@@ -422,6 +631,10 @@ void Game::DrawLoading() {
 	// draw Bar
 	DrawRectangleLines(sw / 2 - 200, sh / 2, 400, 30, WHITE);
 	DrawRectangle(sw / 2 - 195, sh / 2 + 5, (int)(3.9f * loadingProgress), 20, WHITE);
+	DrawText(TextFormat("%d / %d chunks in view", loadStartReady, loadStartCount), sw / 2 - 200, sh / 2 + 40, 10, GRAY);
+	DrawText(TextFormat("%d / %d chunks generated", loadNext, (int)loadOrder.size()), sw / 2 - 200, sh / 2 + 55, 10, GRAY);
+
+	if (GuiButton({ (float)sw / 2 - 60, (float)sh / 2 + 80, 120, 30 }, "CANCEL (ESC)")) CancelLoading();
 
 	EndDrawing();
 }
\ No newline at end of file
@@ -5,6 +5,13 @@
 #include "../world/chunk_manager.h"
 #include "../player/player.h"
 #include "../graphics/renderer.h"
+#include "input.h"
+
+// chunks generated per loading frame for every thread the job system has
+#define LOAD_BATCH_PER_THREAD 2
+
+// play starts once the chunks this close to the player that are in view are meshed
+#define LOAD_START_RADIUS 2
 
 /**
  * main game state enum
@@ -27,6 +34,11 @@ public:
 	void Draw();
 	void ShutDown();
 
+	/**
+	 * starts a fresh world from a replay header and feeds the recorded input
+	 */
+	bool StartReplay(const char* path);
+
 private:
 	ChunkManager world;
 	Player player;
@@ -49,16 +61,34 @@ private:
 	// loading State
 	int loadingProgress;    // 0 to 100
 	bool isNewGame;         // are we generating or loading?
+	std::vector<ChunkCoord> loadOrder; // preload offsets, nearest first
+	int loadNext;           // first entry of loadOrder not generated yet
+	int loadStartCount;     // chunks that must be meshed before play starts
+	int loadStartReady;     // how many of those are
 
 	// Auto-Save
 	float autoSaveTimer;
 
+	// input recording / replay (fixed REPLAY_TIMESTEP while either is active)
+	InputRecorder recorder;
+	InputReplay replay;
+	InputFrame pendingInput;
+	float stepAccumulator;
+	void ToggleRecording();
+	void UpdatePhysics(float dt);
+	void StepPlayer(float dt, const InputFrame& input);
+
+	// chunk telemetry csv
+	float telemetryTimer;
+	void DumpTelemetry();
+
 	// internal Helpers
 	void UpdateMenu();
 	void DrawMenu();
 
-	void UpdateLoading(); // function that loads chunks 1-by-1
+	void UpdateLoading(); // generates a batch of chunks per frame on the job system
 	void DrawLoading();
+	void CancelLoading();
 
 	// UI Buffers
 	char worldNameBuffer[64]; // text box input
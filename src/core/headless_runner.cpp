@@ -0,0 +1,149 @@
+#include "headless_runner.h"
+#include "input.h"
+#include "../player/player.h"
+#include "../world/chunk_manager.h"
+#include "../world/world_generator.h"
+#include "raymath.h"
+#include <algorithm>
+
+// same cadence as Game::Update
+static const float PHYSICS_STEP = 0.05f;
+
+/**
+ * adds the frame the profiler just closed to the run totals
+ */
+static void CollectZones(HeadlessResult& result) {
+    for (int i = 0; i < (int)ProfileZone::COUNT; i++) {
+        result.zoneTotalMs[i] += Profiler::GetZoneLast((ProfileZone)i);
+    }
+}
+
+bool RunHeadlessReplay(const char* path, HeadlessResult& result) {
+    InputReplay replay;
+    if (!replay.Open(path)) return false;
+
+    const ReplayHeader& header = replay.GetHeader();
+    WorldGenerator::worldSeed = header.seed;
+    WorldGenerator::terrainVersion = TERRAIN_VERSION;
+
+    ChunkManager world;
+    world.Init();
+
+    Player player;
+    player.Init();
+    player.position = header.position;
+    player.cameraAngleX = header.cameraAngleX;
+    player.cameraAngleY = header.cameraAngleY;
+    player.isFlying = header.isFlying;
+
+    // the in-window replay starts from the loading screen, so the run starts
+    // from the same preloaded view area (unloaded cells collide as stone and
+    // miss edits, the recording would drift off its path otherwise)
+    std::vector<ChunkCoord> loadOrder;
+    ChunkManager::RankOffsets(RENDER_DISTANCE + 1, { 0, 0, 0 }, loadOrder);
+    int px = (int)floor(player.position.x / CHUNK_SIZE);
+    int pz = (int)floor(player.position.z / CHUNK_SIZE);
+    std::vector<ChunkCoord> batch;
+    for (const ChunkCoord& offset : loadOrder) batch.push_back({ px + offset.x, pz + offset.z });
+    world.GenerateBatch(batch);
+    for (const ChunkCoord& coord : batch) world.RebuildMesh(coord.x, coord.z, nullptr);
+
+    // drop anything the profiler collected before the run
+    Profiler::BeginFrame();
+
+    double runStart = Profiler::NowMs();
+    float physicsTimer = 0.0f;
+    InputFrame input;
+
+    while (replay.Next(input)) {
+        Profiler::BeginFrame();
+        if (result.frames > 0) CollectZones(result);
+
+        double start = Profiler::NowMs();
+
+        // stream first so edits near the player always hit meshed chunks
+        world.PredictMovement(player.position, player.velocity);
+        world.UpdateHeadless(player.position, Vector3Subtract(player.camera.target, player.camera.position));
+
+        physicsTimer += REPLAY_TIMESTEP;
+        if (physicsTimer >= PHYSICS_STEP) {
+            physicsTimer -= PHYSICS_STEP;
+            world.UpdateChunkPhysics();
+            world.UpdateFluids();
+            world.UpdateBlockTicks();
+        }
+
+        player.Update(REPLAY_TIMESTEP, world, input);
+        player.UpdateRaycast(world);
+        player.HandleInput(world, input);
+
+        result.frameMs.push_back(Profiler::NowMs() - start);
+        result.frames++;
+    }
+
+    Profiler::BeginFrame();
+    if (result.frames > 0) CollectZones(result);
+
+    result.totalMs = Profiler::NowMs() - runStart;
+    result.chunksLoaded = (int)world.GetChunkCount();
+    const ChunkStats& stats = world.GetStats();
+    result.chunksMeshed = stats.resident - stats.waiting - stats.pendingMesh;
+    result.firstMeshes = stats.firstMeshes;
+    result.borderFixups = stats.borderFixups;
+    result.meshRebuilds = stats.meshRebuilds;
+    result.missedChunks = stats.missedChunks;
+    if (result.frames > 0) result.missedPerMinute = stats.missedChunks * 60.0f / (result.frames * REPLAY_TIMESTEP);
+    result.prefetched = stats.prefetched;
+    result.prefetchCancelled = stats.prefetchCancelled;
+    result.chunkAllocations = stats.chunkAllocations;
+    result.coldChunks = stats.coldChunks;
+    result.coldBytes = stats.coldBytes;
+    result.thawed = stats.thawed;
+    result.evicted = stats.evicted;
+    result.finalPosition = player.position;
+
+    world.UnloadAll();
+    return true;
+}
+
+void WriteHeadlessReport(FILE* f, const char* path, const HeadlessResult& result) {
+    std::vector<double> sorted = result.frameMs;
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum = 0.0;
+    for (double ms : sorted) sum += ms;
+    double mean = sorted.empty() ? 0.0 : sum / sorted.size();
+    double p50 = sorted.empty() ? 0.0 : sorted[(sorted.size() - 1) / 2];
+    double p95 = sorted.empty() ? 0.0 : sorted[(size_t)(0.95 * (sorted.size() - 1))];
+    double peak = sorted.empty() ? 0.0 : sorted.back();
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"replay\": \"%s\",\n", path);
+    fprintf(f, "  \"seed\": %d,\n", WorldGenerator::worldSeed);
+    fprintf(f, "  \"render_distance\": %d,\n", RENDER_DISTANCE);
+    fprintf(f, "  \"frames\": %d,\n", result.frames);
+    fprintf(f, "  \"total_ms\": %.3f,\n", result.totalMs);
+    fprintf(f, "  \"frame_ms\": { \"mean\": %.4f, \"median\": %.4f, \"p95\": %.4f, \"max\": %.4f },\n", mean, p50, p95, peak);
+    fprintf(f, "  \"zones_ms\": {");
+    for (int i = 0; i < (int)ProfileZone::COUNT; i++) {
+        fprintf(f, "%s \"%s\": %.3f", i > 0 ? "," : "", Profiler::GetZoneName((ProfileZone)i), result.zoneTotalMs[i]);
+    }
+    fprintf(f, " },\n");
+    fprintf(f, "  \"chunks_loaded\": %d,\n", result.chunksLoaded);
+    fprintf(f, "  \"chunks_meshed\": %d,\n", result.chunksMeshed);
+    fprintf(f, "  \"first_meshes\": %d,\n", result.firstMeshes);
+    fprintf(f, "  \"border_fixups\": %d,\n", result.borderFixups);
+    fprintf(f, "  \"mesh_rebuilds\": %d,\n", result.meshRebuilds);
+    fprintf(f, "  \"missed_chunks\": %d,\n", result.missedChunks);
+    fprintf(f, "  \"missed_per_minute\": %.3f,\n", result.missedPerMinute);
+    fprintf(f, "  \"prefetched\": %d,\n", result.prefetched);
+    fprintf(f, "  \"prefetch_cancelled\": %d,\n", result.prefetchCancelled);
+    fprintf(f, "  \"chunk_allocations\": %d,\n", result.chunkAllocations);
+    fprintf(f, "  \"cold_chunks\": %d,\n", result.coldChunks);
+    fprintf(f, "  \"cold_bytes\": %zu,\n", result.coldBytes);
+    fprintf(f, "  \"thawed\": %d,\n", result.thawed);
+    fprintf(f, "  \"evicted\": %d,\n", result.evicted);
+    fprintf(f, "  \"final_position\": [%.4f, %.4f, %.4f]\n",
+        result.finalPosition.x, result.finalPosition.y, result.finalPosition.z);
+    fprintf(f, "}\n");
+}
@@ -0,0 +1,47 @@
+#ifndef HEADLESS_RUNNER_H
+#define HEADLESS_RUNNER_H
+
+#include "raylib.h"
+#include "profiler.h"
+#include <vector>
+#include <cstdio>
+
+/**
+ * what one headless replay did and how long it took
+ */
+struct HeadlessResult {
+    int frames = 0;
+    std::vector<double> frameMs;                      // wall time of every simulated step
+    double zoneTotalMs[(int)ProfileZone::COUNT] = {}; // self time summed over the run
+    double totalMs = 0.0;
+    int chunksLoaded = 0;
+    int chunksMeshed = 0;
+    int firstMeshes = 0;                              // chunks meshed for the first time
+    int borderFixups = 0;                             // rebuilds after a side neighbour arrived
+    int meshRebuilds = 0;                             // rebuilds after physics, water, ticks and edits
+    int missedChunks = 0;                             // entered render distance with nothing to draw
+    float missedPerMinute = 0.0f;                     // the same per minute of replay time
+    int prefetched = 0;                               // generated ahead on the predicted path
+    int prefetchCancelled = 0;                        // queued prefetches a turn or stop dropped
+    int chunkAllocations = 0;                         // chunks the pool had to allocate
+    int coldChunks = 0;                               // compressed chunks at the end of the run
+    size_t coldBytes = 0;                             // their compressed size
+    int thawed = 0;                                   // cold chunks expanded again
+    int evicted = 0;                                  // cold chunks dropped over the memory budget
+    Vector3 finalPosition = {};                       // identical between runs of the same file
+};
+
+/**
+ * plays a recording back at REPLAY_TIMESTEP without a window
+ * runs generation, physics, lighting and cpu meshing exactly like the game,
+ * only the gpu upload and drawing are skipped
+ * returns false if the replay could not be opened
+ */
+bool RunHeadlessReplay(const char* path, HeadlessResult& result);
+
+/**
+ * prints the result as json (frame percentiles and per-zone totals)
+ */
+void WriteHeadlessReport(FILE* f, const char* path, const HeadlessResult& result);
+
+#endif
@@ -0,0 +1,120 @@
+#include "input.h"
+#include <cstring>
+
+// replay file header (magic + version)
+static const char* REPLAY_MAGIC = "VRPL";
+static const int REPLAY_VERSION = 1;
+
+InputFrame PollInput() {
+    InputFrame frame = {};
+
+    Vector2 mouseDelta = GetMouseDelta();
+    frame.mouseDX = mouseDelta.x;
+    frame.mouseDY = mouseDelta.y;
+    frame.wheel = GetMouseWheelMove();
+
+    if (IsKeyDown(KEY_W)) frame.held |= INPUT_FORWARD;
+    if (IsKeyDown(KEY_S)) frame.held |= INPUT_BACK;
+    if (IsKeyDown(KEY_A)) frame.held |= INPUT_LEFT;
+    if (IsKeyDown(KEY_D)) frame.held |= INPUT_RIGHT;
+    if (IsKeyDown(KEY_SPACE)) frame.held |= INPUT_JUMP;
+    if (IsKeyDown(KEY_LEFT_CONTROL)) frame.held |= INPUT_DOWN;
+    if (IsKeyDown(KEY_LEFT_SHIFT)) frame.held |= INPUT_SPRINT;
+
+    if (IsKeyPressed(KEY_F)) frame.pressed |= INPUT_TOGGLE_FLY;
+    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) frame.pressed |= INPUT_BREAK;
+    if (IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)) frame.pressed |= INPUT_PLACE;
+    if (IsKeyPressed(KEY_X)) frame.pressed |= INPUT_EXPLODE;
+
+    for (int i = 0; i < 9; i++) {
+        if (IsKeyPressed(KEY_ONE + i)) frame.pressed |= (INPUT_SLOT_1 << i);
+    }
+
+    return frame;
+}
+
+void MergeInput(InputFrame& into, const InputFrame& from) {
+    into.mouseDX += from.mouseDX;
+    into.mouseDY += from.mouseDY;
+    into.wheel += from.wheel;
+    into.held = from.held;
+    into.pressed |= from.pressed;
+}
+
+bool InputRecorder::Start(const char* path, const ReplayHeader& header) {
+    out.open(path, std::ios::binary);
+    if (!out) return false;
+
+    out.write(REPLAY_MAGIC, 4);
+    out.write((char*)&REPLAY_VERSION, sizeof(int));
+    out.write((char*)&header.seed, sizeof(int));
+    out.write((char*)&header.position, sizeof(Vector3));
+    out.write((char*)&header.cameraAngleX, sizeof(float));
+    out.write((char*)&header.cameraAngleY, sizeof(float));
+    char flying = header.isFlying ? 1 : 0;
+    out.write(&flying, 1);
+    return true;
+}
+
+void InputRecorder::Record(const InputFrame& frame) {
+    if (!out.is_open()) return;
+
+    // field by field so the file layout doesn't depend on struct padding
+    out.write((char*)&frame.mouseDX, sizeof(float));
+    out.write((char*)&frame.mouseDY, sizeof(float));
+    out.write((char*)&frame.wheel, sizeof(float));
+    out.write((char*)&frame.held, sizeof(uint32_t));
+    out.write((char*)&frame.pressed, sizeof(uint32_t));
+}
+
+void InputRecorder::Stop() {
+    if (out.is_open()) out.close();
+}
+
+bool InputReplay::Open(const char* path) {
+    in.open(path, std::ios::binary);
+    if (!in) return false;
+
+    char magic[5] = { 0 };
+    int version = 0;
+    in.read(magic, 4);
+    in.read((char*)&version, sizeof(int));
+    if (strcmp(magic, REPLAY_MAGIC) != 0 || version != REPLAY_VERSION) {
+        in.close();
+        return false;
+    }
+
+    in.read((char*)&header.seed, sizeof(int));
+    in.read((char*)&header.position, sizeof(Vector3));
+    in.read((char*)&header.cameraAngleX, sizeof(float));
+    in.read((char*)&header.cameraAngleY, sizeof(float));
+    char flying = 0;
+    in.read(&flying, 1);
+    header.isFlying = flying != 0;
+
+    if (!in) {
+        in.close();
+        return false;
+    }
+    return true;
+}
+
+bool InputReplay::Next(InputFrame& frame) {
+    if (!in.is_open()) return false;
+
+    in.read((char*)&frame.mouseDX, sizeof(float));
+    in.read((char*)&frame.mouseDY, sizeof(float));
+    in.read((char*)&frame.wheel, sizeof(float));
+    in.read((char*)&frame.held, sizeof(uint32_t));
+    in.read((char*)&frame.pressed, sizeof(uint32_t));
+
+    if (!in) {
+        in.close();
+        return false;
+    }
+    return true;
+}
+
+void InputReplay::Close() {
+    if (in.is_open()) in.close();
+}
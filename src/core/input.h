@@ -0,0 +1,97 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include "raylib.h"
+#include <cstdint>
+#include <fstream>
+
+// simulation step used while recording or replaying, independent of the fps
+#define REPLAY_TIMESTEP (1.0f / 60.0f)
+#define MAX_STEPS_PER_FRAME 5
+
+/**
+ * gameplay actions, used as bits in InputFrame
+ */
+enum InputAction : uint32_t {
+    INPUT_FORWARD    = 1 << 0,
+    INPUT_BACK       = 1 << 1,
+    INPUT_LEFT       = 1 << 2,
+    INPUT_RIGHT      = 1 << 3,
+    INPUT_JUMP       = 1 << 4, // also fly up
+    INPUT_DOWN       = 1 << 5, // fly down
+    INPUT_SPRINT     = 1 << 6,
+    INPUT_TOGGLE_FLY = 1 << 7,
+    INPUT_BREAK      = 1 << 8,
+    INPUT_PLACE      = 1 << 9,
+    INPUT_SLOT_1     = 1 << 10, // slots 1-9 use bits 10-18
+    INPUT_EXPLODE    = 1 << 19
+};
+
+/**
+ * one frame of player input, polled live or read back from a replay
+ * the player only ever looks at this, never at the raylib input functions
+ */
+struct InputFrame {
+    float mouseDX;
+    float mouseDY;
+    float wheel;
+    uint32_t held;    // actions held down this frame
+    uint32_t pressed; // actions that went down this frame
+
+    bool IsHeld(uint32_t action) const { return (held & action) != 0; }
+    bool IsPressed(uint32_t action) const { return (pressed & action) != 0; }
+};
+
+/**
+ * snapshot of the world/player needed to start a replay from the same place
+ */
+struct ReplayHeader {
+    int seed;
+    Vector3 position;
+    float cameraAngleX;
+    float cameraAngleY;
+    bool isFlying;
+};
+
+/**
+ * reads the keyboard and mouse into an InputFrame
+ */
+InputFrame PollInput();
+
+/**
+ * folds a newer frame into one that hasn't been consumed yet
+ * (mouse motion adds up, presses are kept, held keys are the latest)
+ */
+void MergeInput(InputFrame& into, const InputFrame& from);
+
+/**
+ * streams input frames to a .rpl file
+ */
+class InputRecorder {
+public:
+    bool Start(const char* path, const ReplayHeader& header);
+    void Record(const InputFrame& frame);
+    void Stop();
+    bool IsRecording() const { return out.is_open(); }
+
+private:
+    std::ofstream out;
+};
+
+/**
+ * plays a .rpl file back one frame at a time
+ */
+class InputReplay {
+public:
+    bool Open(const char* path);
+    bool Next(InputFrame& frame); // false once the recording runs out
+    void Close();
+    bool IsPlaying() const { return in.is_open(); }
+    const ReplayHeader& GetHeader() const { return header; }
+
+private:
+    std::ifstream in;
+    ReplayHeader header = {};
+};
+
+#endif
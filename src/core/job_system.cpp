@@ -0,0 +1,111 @@
+#include "job_system.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+
+static std::vector<std::thread> workers;
+static std::mutex poolMutex;
+static std::condition_variable wakeWorkers;
+static std::condition_variable batchDone;
+
+// current batch, handed over under poolMutex
+static const std::function<void(int)>* currentJob = nullptr;
+static unsigned long long batchId = 0;
+static int joinedWorkers = 0;  // workers that picked the batch up
+static int busyWorkers = 0;    // ... and haven't finished it yet
+static bool stopping = false;
+static bool started = false;
+
+static std::atomic<int> nextIndex(0);
+static int jobCount = 0;
+
+static void RunIndices(const std::function<void(int)>& job) {
+    int i;
+    while ((i = nextIndex.fetch_add(1)) < jobCount) job(i);
+}
+
+static void WorkerLoop() {
+    unsigned long long seen = 0;
+    while (true) {
+        const std::function<void(int)>* job;
+        {
+            std::unique_lock<std::mutex> lock(poolMutex);
+            wakeWorkers.wait(lock, [&] { return stopping || batchId != seen; });
+            if (stopping) return;
+            seen = batchId;
+            job = currentJob;
+            joinedWorkers++;
+            busyWorkers++;
+        }
+
+        RunIndices(*job);
+
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            busyWorkers--;
+        }
+        batchDone.notify_all();
+    }
+}
+
+// joins the workers at exit if nobody called Shutdown
+static struct PoolGuard {
+    ~PoolGuard() { JobSystem::Shutdown(); }
+} poolGuard;
+
+void JobSystem::Init(int workerCount) {
+    if (started) return;
+    started = true;
+    stopping = false;
+
+    if (workerCount < 0) {
+        int hardware = (int)std::thread::hardware_concurrency();
+        workerCount = hardware > 1 ? hardware - 1 : 0;
+    }
+    for (int i = 0; i < workerCount; i++) workers.emplace_back(WorkerLoop);
+}
+
+void JobSystem::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        stopping = true;
+    }
+    wakeWorkers.notify_all();
+    for (std::thread& worker : workers) worker.join();
+    workers.clear();
+    started = false;
+}
+
+int JobSystem::GetWorkerCount() {
+    return (int)workers.size();
+}
+
+void JobSystem::ParallelFor(int count, const std::function<void(int)>& job) {
+    if (count <= 0) return;
+    if (!started) Init();
+
+    if (workers.empty() || count == 1) {
+        for (int i = 0; i < count; i++) job(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        currentJob = &job;
+        jobCount = count;
+        nextIndex = 0;
+        joinedWorkers = 0;
+        busyWorkers = 0;
+        batchId++;
+    }
+    wakeWorkers.notify_all();
+
+    RunIndices(job);
+
+    // every worker has to have seen the batch before `job` goes out of scope
+    std::unique_lock<std::mutex> lock(poolMutex);
+    batchDone.wait(lock, [] { return joinedWorkers == (int)workers.size() && busyWorkers == 0; });
+    currentJob = nullptr;
+}
@@ -0,0 +1,27 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <functional>
+
+/**
+ * static worker pool for data-parallel loops
+ * workers are started on first use (hardware threads - 1) and the calling
+ * thread takes part in every loop, so one core machines just run inline.
+ * jobs must not call ParallelFor themselves.
+ */
+class JobSystem {
+public:
+    /**
+     * starts the workers, workerCount < 0 picks one per spare hardware thread
+     */
+    static void Init(int workerCount = -1);
+    static void Shutdown();
+    static int GetWorkerCount();
+
+    /**
+     * runs job(0) .. job(count - 1) across the pool and returns once all are done
+     */
+    static void ParallelFor(int count, const std::function<void(int)>& job);
+};
+
+#endif
@@ -0,0 +1,177 @@
+#include "profiler.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <cstdio>
+
+// cap on recorded trace events (~8 MB), capture stops filling past this
+static const size_t MAX_TRACE_EVENTS = 250000;
+static const int MAX_SCOPE_DEPTH = 32;
+
+struct TraceEvent {
+    double startMs;
+    double durationMs;
+    int thread;
+    int8_t zone; // -1 = frame marker
+};
+
+static const char* zoneNames[(int)ProfileZone::COUNT] = {
+    "Physics", "Block Ticks", "Fluids", "Generation", "Lighting", "Meshing", "World Draw", "Save"
+};
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+// current frame, accumulated in microseconds so threads can add atomically
+static std::atomic<long long> zoneMicros[(int)ProfileZone::COUNT];
+
+// rolling history (main thread only)
+static float frameHistory[PROFILER_HISTORY];
+static float zoneHistory[(int)ProfileZone::COUNT][PROFILER_HISTORY];
+static int historyHead = 0;
+static double frameStartMs = -1.0;
+
+// trace capture
+static std::mutex traceMutex;
+static std::vector<TraceEvent> traceEvents;
+static std::atomic<bool> capturing(false);
+static std::atomic<int> nextThreadId(1);
+
+// per-thread nesting, used to turn inclusive times into self times
+static thread_local double childMs[MAX_SCOPE_DEPTH];
+static thread_local int scopeDepth = 0;
+static thread_local int threadId = 0;
+
+static int GetThreadId() {
+    if (threadId == 0) threadId = nextThreadId++;
+    return threadId;
+}
+
+double Profiler::NowMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void Profiler::BeginFrame() {
+    double now = NowMs();
+
+    if (frameStartMs >= 0.0) {
+        frameHistory[historyHead] = (float)(now - frameStartMs);
+        for (int i = 0; i < (int)ProfileZone::COUNT; i++) {
+            zoneHistory[i][historyHead] = (float)(zoneMicros[i].exchange(0) / 1000.0);
+        }
+        historyHead = (historyHead + 1) % PROFILER_HISTORY;
+
+        if (capturing) {
+            std::lock_guard<std::mutex> lock(traceMutex);
+            if (traceEvents.size() < MAX_TRACE_EVENTS) {
+                traceEvents.push_back({ frameStartMs, now - frameStartMs, GetThreadId(), -1 });
+            }
+        }
+    }
+    frameStartMs = now;
+}
+
+void Profiler::AddSample(ProfileZone zone, double startMs, double durationMs, double selfMs) {
+    zoneMicros[(int)zone] += (long long)(selfMs * 1000.0);
+
+    if (capturing) {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        if (traceEvents.size() < MAX_TRACE_EVENTS) {
+            traceEvents.push_back({ startMs, durationMs, GetThreadId(), (int8_t)zone });
+        }
+    }
+}
+
+const char* Profiler::GetZoneName(ProfileZone zone) {
+    return zoneNames[(int)zone];
+}
+
+float Profiler::GetZoneAverage(ProfileZone zone) {
+    float sum = 0.0f;
+    for (int i = 0; i < PROFILER_HISTORY; i++) sum += zoneHistory[(int)zone][i];
+    return sum / PROFILER_HISTORY;
+}
+
+float Profiler::GetZoneMax(ProfileZone zone) {
+    float peak = 0.0f;
+    for (int i = 0; i < PROFILER_HISTORY; i++) {
+        if (zoneHistory[(int)zone][i] > peak) peak = zoneHistory[(int)zone][i];
+    }
+    return peak;
+}
+
+float Profiler::GetZoneLast(ProfileZone zone) {
+    return zoneHistory[(int)zone][(historyHead + PROFILER_HISTORY - 1) % PROFILER_HISTORY];
+}
+
+float Profiler::GetFrameAverage() {
+    float sum = 0.0f;
+    for (int i = 0; i < PROFILER_HISTORY; i++) sum += frameHistory[i];
+    return sum / PROFILER_HISTORY;
+}
+
+const float* Profiler::GetFrameHistory() {
+    return frameHistory;
+}
+
+int Profiler::GetHistoryHead() {
+    return historyHead;
+}
+
+void Profiler::StartCapture() {
+    std::lock_guard<std::mutex> lock(traceMutex);
+    traceEvents.clear();
+    capturing = true;
+}
+
+void Profiler::StopCapture() {
+    capturing = false;
+}
+
+bool Profiler::IsCapturing() {
+    return capturing;
+}
+
+int Profiler::GetCapturedEventCount() {
+    std::lock_guard<std::mutex> lock(traceMutex);
+    return (int)traceEvents.size();
+}
+
+/**
+ * writes the captured events in the chrome trace event format
+ */
+bool Profiler::ExportChromeTrace(const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+
+    std::lock_guard<std::mutex> lock(traceMutex);
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (size_t i = 0; i < traceEvents.size(); i++) {
+        const TraceEvent& e = traceEvents[i];
+        const char* name = e.zone < 0 ? "Frame" : zoneNames[e.zone];
+        // chrome wants microseconds
+        fprintf(f, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}%s\n",
+            name, e.zone < 0 ? "frame" : "engine", e.startMs * 1000.0, e.durationMs * 1000.0, e.thread,
+            i + 1 < traceEvents.size() ? "," : "");
+    }
+    fprintf(f, "]}\n");
+    fclose(f);
+    return true;
+}
+
+ProfileScope::ProfileScope(ProfileZone zone) : zone(zone) {
+    start = Profiler::NowMs();
+    if (scopeDepth < MAX_SCOPE_DEPTH) childMs[scopeDepth] = 0.0;
+    scopeDepth++;
+}
+
+ProfileScope::~ProfileScope() {
+    double duration = Profiler::NowMs() - start;
+    scopeDepth--;
+
+    double self = duration;
+    if (scopeDepth < MAX_SCOPE_DEPTH) self -= childMs[scopeDepth];
+    if (scopeDepth > 0 && scopeDepth - 1 < MAX_SCOPE_DEPTH) childMs[scopeDepth - 1] += duration;
+
+    Profiler::AddSample(zone, start, duration, self);
+}
@@ -0,0 +1,81 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+
+/**
+ * hot-path subsystems tracked by the frame profiler
+ */
+enum class ProfileZone : uint8_t {
+    PHYSICS,     // UpdateChunkPhysics
+    BLOCK_TICKS, // UpdateBlockTicks (scheduled + random ticks)
+    FLUIDS,      // UpdateFluids (water flow)
+    GENERATION,  // GenerateChunk (terrain + structures)
+    LIGHTING,    // ComputeChunkLighting
+    MESHING,     // BuildChunkMesh
+    WORLD_DRAW,  // UpdateAndDraw (self time, nested zones excluded)
+    SAVE,        // SaveMap
+
+    COUNT
+};
+
+// frames kept for the rolling graph
+#define PROFILER_HISTORY 240
+
+/**
+ * static frame profiler
+ * scoped timers add self time (children excluded) to per-zone counters,
+ * which are rolled into a per-frame history. while a capture is running
+ * every scope is also recorded as a chrome trace event.
+ * safe to use from worker threads.
+ */
+class Profiler {
+public:
+    /**
+     * closes the previous frame and starts a new one (call once per loop)
+     */
+    static void BeginFrame();
+
+    static double NowMs();
+    static void AddSample(ProfileZone zone, double startMs, double durationMs, double selfMs);
+
+    static const char* GetZoneName(ProfileZone zone);
+
+    // rolling stats, in milliseconds
+    static float GetZoneAverage(ProfileZone zone);
+    static float GetZoneMax(ProfileZone zone);
+    static float GetZoneLast(ProfileZone zone); // most recently closed frame
+    static float GetFrameAverage();
+
+    /**
+     * ring buffer of frame times, oldest first when read from GetHistoryHead()
+     */
+    static const float* GetFrameHistory();
+    static int GetHistoryHead();
+
+    // chrome trace capture (open in chrome://tracing or ui.perfetto.dev)
+    static void StartCapture();
+    static void StopCapture();
+    static bool IsCapturing();
+    static int GetCapturedEventCount();
+    static bool ExportChromeTrace(const char* path);
+};
+
+/**
+ * RAII timer for one zone
+ */
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileZone zone);
+    ~ProfileScope();
+
+private:
+    ProfileZone zone;
+    double start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(zone) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(zone)
+
+#endif
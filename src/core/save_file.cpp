@@ -0,0 +1,41 @@
+#include "save_file.h"
+#include <cstring>
+
+static const char* SAVE_MAGIC = "VOXL";
+
+void WriteSaveHeader(std::ostream& out, const SaveHeader& header) {
+    int version = SAVE_VERSION;
+    out.write(SAVE_MAGIC, 4);
+    out.write((char*)&version, sizeof(int));
+
+    // world global data
+    out.write((char*)&header.seed, sizeof(int));
+    out.write((char*)&header.terrain, sizeof(int));
+
+    // player data, the inventory is plain data and goes out as is
+    out.write((char*)&header.position, sizeof(Vector3));
+    out.write((char*)&header.cameraAngleX, sizeof(float));
+    out.write((char*)&header.cameraAngleY, sizeof(float));
+    out.write((char*)&header.inventory, sizeof(Inventory));
+}
+
+const char* ReadSaveHeader(std::istream& in, SaveHeader& header) {
+    char magic[5] = { 0 };
+    in.read(magic, 4);
+    if (strcmp(magic, SAVE_MAGIC) != 0) return "INVALID SAVE FILE";
+
+    in.read((char*)&header.version, sizeof(int));
+    if (header.version < 1 || header.version > SAVE_VERSION) return "UNSUPPORTED SAVE VERSION";
+
+    in.read((char*)&header.seed, sizeof(int));
+
+    // before version 3 the terrain went with the save version (lakes came with 2)
+    if (header.version >= 3) in.read((char*)&header.terrain, sizeof(int));
+    else header.terrain = header.version >= 2 ? 2 : 1;
+    in.read((char*)&header.position, sizeof(Vector3));
+    in.read((char*)&header.cameraAngleX, sizeof(float));
+    in.read((char*)&header.cameraAngleY, sizeof(float));
+    in.read((char*)&header.inventory, sizeof(Inventory));
+    if (!in) return "INVALID SAVE FILE";
+    return nullptr;
+}
@@ -0,0 +1,34 @@
+#ifndef SAVE_FILE_H
+#define SAVE_FILE_H
+
+#include "raylib.h"
+#include "constants.h"
+#include "../player/inventory.h"
+#include <iostream>
+
+/**
+ * everything a .vxl world save holds before its chunk list
+ */
+struct SaveHeader {
+    int version = SAVE_VERSION;
+    int seed = 0;
+    int terrain = TERRAIN_VERSION;
+    Vector3 position = {};
+    float cameraAngleX = 0.0f;
+    float cameraAngleY = 0.0f;
+    Inventory inventory = {};
+};
+
+/**
+ * magic, version, seed, terrain version and player data (always written
+ * as SAVE_VERSION)
+ */
+void WriteSaveHeader(std::ostream& out, const SaveHeader& header);
+
+/**
+ * reads a header written by WriteSaveHeader (or an older version)
+ * returns nullptr on success, otherwise what is wrong with the file
+ */
+const char* ReadSaveHeader(std::istream& in, SaveHeader& header);
+
+#endif
@@ -4,6 +4,8 @@
 #include "../blocks/block_manager.h"
 #include "../blocks/block_types.h"
 #include "raymath.h"
+#include "../core/profiler.h"
+#include <cstdio>
 
 #define RAYGUI_IMPLEMENTATION
 #include "raygui.h"
@@ -64,8 +66,28 @@ uniform float sunBrightness;
 uniform vec3 playerLightPos;     
 uniform float playerLightStrength; // (0.0 = Off, 1.0 = On)
 
+// Far terrain cross-fade: over the last fadeWidth blocks inside the chunk
+// square (nearBox = min x, min z, max x, max z) chunk pixels dither out and
+// far terrain pixels dither in, with the same threshold so they never overlap
+uniform vec4 nearBox;
+uniform float fadeWidth; // 0 = no far terrain
+uniform float farPass;   // 1 while drawing far terrain
+
+float Bayer4(vec2 p) {
+    const int pattern[16] = int[16](0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5);
+    int index = int(mod(p.x, 4.0)) + int(mod(p.y, 4.0)) * 4;
+    return (float(pattern[index]) + 0.5) / 16.0;
+}
+
 void main()
 {
+    if (fadeWidth > 0.0) {
+        vec2 inside = min(fragPosition.xz - nearBox.xy, nearBox.zw - fragPosition.xz);
+        float edge = clamp(min(inside.x, inside.y) / fadeWidth, 0.0, 1.0);
+        bool chunkShows = edge > Bayer4(gl_FragCoord.xy);
+        if (chunkShows == (farPass > 0.5)) discard;
+    }
+
     vec4 texColor = texture(texture0, fragTexCoord);
     
     // 1. STATIC LIGHT (Baked in chunks)
@@ -109,6 +131,7 @@ void main()
 void Renderer::Init() {
     handBobbing = 0.0f;
     cloudScroll = 0.0f;
+    traceStatus[0] = '\0';
 
     // load block textures using blockmanager
     textures[(int)BlockType::DIRT] = BlockManager::GenDirtTexture(BLOCK_TEX_SIZE);
@@ -125,6 +148,7 @@ void Renderer::Init() {
     textures[(int)BlockType::SNOW_LEAVES] = BlockManager::GenSnowLeavesSideTexture(BLOCK_TEX_SIZE);
     textures[(int)BlockType::TORCH] = BlockManager::GenTorchTexture(BLOCK_TEX_SIZE);
     textures[(int)BlockType::GLOWSTONE] = BlockManager::GenGlowstoneTexture(BLOCK_TEX_SIZE);
+    textures[(int)BlockType::WATER] = BlockManager::GenWaterTexture(BLOCK_TEX_SIZE);
 
     Mesh mesh = GenMeshCube(1.0f, 1.0f, 1.0f);
     blockModel = LoadModelFromMesh(mesh);
@@ -136,8 +160,19 @@ void Renderer::Init() {
     sunBrightnessLoc = GetShaderLocation(fogShader, "sunBrightness");
     playerLightPosLoc = GetShaderLocation(fogShader, "playerLightPos");
     playerLightStrengthLoc = GetShaderLocation(fogShader, "playerLightStrength");
-    float density = 0.005f;
+    nearBoxLoc = GetShaderLocation(fogShader, "nearBox");
+    fadeWidthLoc = GetShaderLocation(fogShader, "fadeWidth");
+    farPassLoc = GetShaderLocation(fogShader, "farPass");
+
+    // fog thickens to ~95% at the edge of the far terrain
+    float density = 1.7f / FarTerrain::GetViewDistance();
     SetShaderValue(fogShader, fogDensityLoc, &density, SHADER_UNIFORM_FLOAT);
+    float fadeWidth = FAR_FADE_WIDTH;
+    SetShaderValue(fogShader, fadeWidthLoc, &fadeWidth, SHADER_UNIFORM_FLOAT);
+
+    // the default far plane (1000) would clip the far terrain
+    rlSetClipPlanes(rlGetCullDistanceNear(), fmax(2000.0, FarTerrain::GetViewDistance() * 1.5));
+    farTerrain.Init(textures);
 
     // sky setup
     Mesh skyMesh = GenMeshCube(1.0f, 1.0f, 1.0f);
@@ -173,6 +208,7 @@ void Renderer::Unload() {
     UnloadModel(skyModel);
     UnloadModel(cloudModel);
     UnloadModel(hazeModel);
+    farTerrain.Unload();
     UnloadTexture(texClouds);
     UnloadTexture(texHaze);
     UnloadShader(fogShader);
@@ -301,7 +337,22 @@ void Renderer::DrawScene(Player& player, ChunkManager& world, float timeOfDay) {
     float fogColor[3] = { skyColor.r / 255.0f, skyColor.g / 255.0f, skyColor.b / 255.0f };
     SetShaderValue(fogShader, fogColorLoc, fogColor, SHADER_UNIFORM_VEC3);
 
-    world.UpdateAndDraw(player.position, textures, fogShader, skyTint);
+    // far terrain first so the chunks' water blends over it
+    float nearBox[4];
+    FarTerrain::GetNearBox(player.position, nearBox);
+    SetShaderValue(fogShader, nearBoxLoc, nearBox, SHADER_UNIFORM_VEC4);
+
+    float farPass = 1.0f;
+    SetShaderValue(fogShader, farPassLoc, &farPass, SHADER_UNIFORM_FLOAT);
+    farTerrain.Update(player.position);
+    rlDisableBackfaceCulling(); // skirts are seen from both sides
+    farTerrain.Draw(fogShader, skyTint);
+    rlEnableBackfaceCulling();
+
+    farPass = 0.0f;
+    SetShaderValue(fogShader, farPassLoc, &farPass, SHADER_UNIFORM_FLOAT);
+    world.PredictMovement(player.position, player.velocity);
+    world.UpdateAndDraw(player.position, Vector3Subtract(player.camera.target, player.camera.position), textures, fogShader, skyTint);
 
     // selection Box
     if (player.isBlockSelected) {
@@ -405,9 +456,9 @@ void Renderer::DrawUI(Player& player, int screenWidth, int screenHeight, const c
 /**
  * renders debug menu with sliders for game parameters
  */
-void Renderer::DrawDebug(Player& player, float& daySpeed, int& timeMode) {
+void Renderer::DrawDebug(Player& player, const ChunkStats& chunkStats, float& daySpeed, int& timeMode) {
     int width = 280;
-    int height = 210;
+    int height = 474;
     int x = GetScreenWidth() - width - 10; 
     int y = 10;                            
 
@@ -423,7 +474,105 @@ void Renderer::DrawDebug(Player& player, float& daySpeed, int& timeMode) {
     GuiToggleGroup(Rectangle{ (float)x + 100, (float)y + 180, 40, 20 }, "AUTO;DAY;NIGHT", &timeMode);
 
     DrawText("Time Mode", x + 20, y + 185, 10, WHITE);
-    DrawText("Press TAB to Close", x + 20, y + 220, 10, WHITE);
+
+    DrawProfiler(x, y + 215, width);
+
+    DrawText("Press TAB to Close", x + 20, y + height - 15, 10, WHITE);
+
+    DrawChunkStats(chunkStats, 10, 40);
+}
+
+/**
+ * chunk streaming panel: residency, queues, memory and draw latency
+ */
+void Renderer::DrawChunkStats(const ChunkStats& stats, int x, int y) {
+    int width = 230;
+    int height = 216;
+    float mb = 1024.0f * 1024.0f;
+
+    DrawRectangle(x, y, width, height, Fade(BLACK, 0.85f));
+    DrawRectangleLines(x, y, width, height, WHITE);
+
+    DrawText("CHUNK STREAMING", x + 10, y + 8, 10, YELLOW);
+    DrawText(TextFormat("Resident  %d  (%.1f MB cpu)", stats.resident, stats.cpuBytes / mb), x + 10, y + 26, 10, WHITE);
+    DrawText(TextFormat("Pending   gen %d  wait %d  mesh %d  dirty %d", stats.pendingGenerate, stats.waiting, stats.pendingMesh, stats.dirty), x + 10, y + 42, 10, WHITE);
+
+    float perChunk = stats.resident > 0 ? stats.gpuBytes / 1024.0f / stats.resident : 0.0f;
+    DrawText(TextFormat("GPU       %.1f MB  (%.0f KB/chunk)", stats.gpuBytes / mb, perChunk), x + 10, y + 58, 10, WHITE);
+
+    float avg = stats.latencyCount > 0 ? (float)(stats.latencyTotalMs / stats.latencyCount) : 0.0f;
+    DrawText(TextFormat("Req->Draw avg %.1f  p95 <%.0f ms", avg, stats.LatencyPercentile(0.95f)), x + 10, y + 74, 10, WHITE);
+    DrawText(TextFormat("Physics   %d chunks  %d cells", stats.physicsChunks, stats.physicsCells), x + 10, y + 90, 10, WHITE);
+    DrawText(TextFormat("Water     %d chunks  %d cells", stats.fluidChunks, stats.fluidCells), x + 10, y + 106, 10, WHITE);
+    DrawText(TextFormat("Far       %d tiles  %.1f MB gpu", farTerrain.GetTileCount(), farTerrain.GetGpuBytes() / mb), x + 10, y + 122, 10, WHITE);
+    DrawText(TextFormat("Ahead     %d  cancelled %d  missed %d", stats.prefetched, stats.prefetchCancelled, stats.missedChunks), x + 10, y + 138, 10, WHITE);
+    DrawText(TextFormat("Pool      %d allocated  %d free", stats.chunkAllocations, stats.pooled), x + 10, y + 154, 10, WHITE);
+    DrawText(TextFormat("Cold      %d  %.1f MB  thawed %d  dropped %d", stats.coldChunks, stats.coldBytes / mb, stats.thawed, stats.evicted), x + 10, y + 170, 10, WHITE);
+
+    // latency histogram, one bar per power-of-two bucket
+    int maxCount = 1;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) maxCount = stats.latencyBuckets[i] > maxCount ? stats.latencyBuckets[i] : maxCount;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        int barH = stats.latencyBuckets[i] * 20 / maxCount;
+        DrawRectangle(x + 10 + i * 17, y + 208 - barH, 14, barH, SKYBLUE);
+    }
+}
+
+/**
+ * frame-time graph, per-subsystem breakdown and trace capture button
+ */
+void Renderer::DrawProfiler(int x, int y, int width) {
+    DrawText(TextFormat("Frame %.2f ms avg", Profiler::GetFrameAverage()), x + 10, y, 10, WHITE);
+
+    // rolling frame graph, 33ms full scale with a 60fps guide line
+    int graphX = x + 10;
+    int graphY = y + 15;
+    int graphW = width - 20;
+    int graphH = 60;
+    float fullScale = 33.3f;
+    DrawRectangle(graphX, graphY, graphW, graphH, Fade(DARKGRAY, 0.5f));
+
+    const float* history = Profiler::GetFrameHistory();
+    int head = Profiler::GetHistoryHead();
+    for (int i = 0; i < PROFILER_HISTORY; i++) {
+        float ms = history[(head + i) % PROFILER_HISTORY];
+        int barH = (int)(MIN(ms / fullScale, 1.0f) * graphH);
+        int barX = graphX + i * graphW / PROFILER_HISTORY;
+        Color color = ms < 16.7f ? GREEN : (ms < 33.3f ? YELLOW : RED);
+        DrawLine(barX, graphY + graphH, barX, graphY + graphH - barH, color);
+    }
+    int guideY = graphY + graphH - (int)(16.7f / fullScale * graphH);
+    DrawLine(graphX, guideY, graphX + graphW, guideY, Fade(WHITE, 0.4f));
+
+    // subsystem breakdown (self time, so rows add up)
+    int rowY = graphY + graphH + 8;
+    DrawText("ms/frame      avg     max", x + 10, rowY, 10, LIGHTGRAY);
+    for (int i = 0; i < (int)ProfileZone::COUNT; i++) {
+        ProfileZone zone = (ProfileZone)i;
+        rowY += 14;
+        DrawText(Profiler::GetZoneName(zone), x + 10, rowY, 10, WHITE);
+        DrawText(TextFormat("%6.2f  %6.2f", Profiler::GetZoneAverage(zone), Profiler::GetZoneMax(zone)), x + 100, rowY, 10, WHITE);
+    }
+
+    // chrome trace capture
+    rowY += 20;
+    if (!Profiler::IsCapturing()) {
+        if (GuiButton(Rectangle{ (float)x + 10, (float)rowY, 120, 20 }, "RECORD TRACE")) {
+            Profiler::StartCapture();
+            traceStatus[0] = '\0';
+        }
+    }
+    else {
+        if (GuiButton(Rectangle{ (float)x + 10, (float)rowY, 120, 20 }, "SAVE TRACE")) {
+            Profiler::StopCapture();
+            if (!DirectoryExists("traces")) MakeDirectory("traces");
+            const char* path = "traces/frame_trace.json";
+            if (Profiler::ExportChromeTrace(path)) snprintf(traceStatus, sizeof(traceStatus), "saved %s", path);
+            else snprintf(traceStatus, sizeof(traceStatus), "trace export failed");
+        }
+        DrawText(TextFormat("%d events", Profiler::GetCapturedEventCount()), x + 140, rowY + 5, 10, RED);
+    }
+    if (traceStatus[0]) DrawText(traceStatus, x + 140, rowY + 5, 10, LIGHTGRAY);
 }
 
 /**
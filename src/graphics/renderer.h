@@ -4,6 +4,7 @@
 #include "raylib.h"
 #include "../player/player.h"
 #include "../world/chunk_manager.h"
+#include "../world/far_terrain.h"
 #include "../blocks/block_types.h"
 
 /**
@@ -26,7 +27,7 @@ public:
     // main draw calls
     void DrawScene(Player& player, ChunkManager& world, float timeOfDay);
     void DrawUI(Player& player, int screenWidth, int screenHeight, const char* msg, float msgTimer);
-    void DrawDebug(Player& player, float& daySpeed, int& timeMode);
+    void DrawDebug(Player& player, const ChunkStats& chunkStats, float& daySpeed, int& timeMode);
 
     Texture2D* GetTextures() { return textures; }
 
@@ -41,11 +42,17 @@ private:
     int playerLightPosLoc;
     int playerLightStrengthLoc;
 
+    // far terrain cross-fade uniforms
+    int nearBoxLoc;
+    int fadeWidthLoc;
+    int farPassLoc;
+
     // environment models
     Model skyModel;
     Model cloudModel;
     Model hazeModel;
     Model blockModel; // used for hand/ui
+    FarTerrain farTerrain;
 
     // environment textures
     Texture2D texClouds;
@@ -56,6 +63,9 @@ private:
     float cloudScroll;
     float handBobbing;
 
+    // profiler panel
+    char traceStatus[128];
+
     // internal helpers
     Texture2D GenerateSkyTexture();
     Texture2D GenerateCloudTexture();
@@ -65,6 +75,8 @@ private:
  */
 Color LerpColor(Color a, Color b, float t);
     void DrawHand(Player& player, Color tint);
+    void DrawProfiler(int x, int y, int width);
+    void DrawChunkStats(const ChunkStats& stats, int x, int y);
 };
 
 #endif
\ No newline at end of file
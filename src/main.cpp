@@ -2,24 +2,63 @@
 #include "core/game.h"
 #include "world/world_generator.h"
 #include "core/constants.h"
+#include "core/profiler.h"
+#include "core/headless_runner.h"
 #include <ctime>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
 
 // render distance setting
 int RENDER_DISTANCE = 4;
 
+// memory budget for chunk data
+int CHUNK_MEMORY_MB = 512;
+
 /**
  * entry point for the application
  * initializes window, game, and main loop
+ *
+ * --replay file.rpl              plays a recorded flight in the window
+ * --replay file.rpl --headless   runs it without a window and prints timings as json
+ * --chunk-memory MB              memory for chunk data (default 512), the
+ *                                compressed cold tier gets what is left over
  */
-int main() {
+int main(int argc, char** argv) {
+    const char* replayPath = nullptr;
+    bool headless = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--replay") && i + 1 < argc) replayPath = argv[++i];
+        else if (!strcmp(argv[i], "--headless")) headless = true;
+        else if (!strcmp(argv[i], "--chunk-memory") && i + 1 < argc) CHUNK_MEMORY_MB = atoi(argv[++i]);
+    }
+
+    if (headless) {
+        if (!replayPath) {
+            fprintf(stderr, "--headless needs --replay file.rpl\n");
+            return 1;
+        }
+        HeadlessResult result;
+        if (!RunHeadlessReplay(replayPath, result)) {
+            fprintf(stderr, "could not read replay %s\n", replayPath);
+            return 1;
+        }
+        WriteHeadlessReport(stdout, replayPath, result);
+        return 0;
+    }
+
     InitWindow(1600, 900, "VOXEL SANDBOX");
     SetTargetFPS(500);
 
     WorldGenerator::worldSeed = GetRandomValue(0, 1000000);
     Game game;
     game.Init();
+    if (replayPath && !game.StartReplay(replayPath)) {
+        TraceLog(LOG_WARNING, "could not read replay %s", replayPath);
+    }
 
     while (!WindowShouldClose()) {
+        Profiler::BeginFrame();
         game.Update();
         game.Draw();
     }
@@ -1,16 +1,25 @@
 #include "player.h"
 #include "raymath.h"
 #include "../blocks/block_types.h"
+#include "../world/world_generator.h"
+#include "../world/voxel_raycast.h"
+#include "../world/block_accessor.h"
+#include "../world/edit_tools.h"
+#include <vector>
 
 /**
  * initializes player state and camera
  */
 void Player::Init() {
-    position = Vector3{ 16.0f, 100.0f, 16.0f };
+    // spawn just above the terrain instead of dropping from the sky
+    position = Vector3{ 16.0f, (float)WorldGenerator::GetSurfaceHeight(16, 16) + 1.0f + EYE_HEIGHT, 16.0f };
     cameraAngleX = 0.0f;
     cameraAngleY = 0.0f;
     isFlying = true;
     verticalVelocity = 0.0f;
+    velocity = { 0, 0, 0 };
+    onGround = false;
+    physicsAccumulator = 0.0f;
 
     // inventory setup
     inventory.selectedSlot = 0;
@@ -28,6 +37,8 @@ void Player::Init() {
     jumpForce = 0.25f;
     moveSpeed = 4.0f;
     flySpeed = 10.0f;
+    reachDistance = DEFAULT_REACH_DISTANCE;
+    isBlockSelected = false;
 
     camera.position = Vector3{ 0.0f, 10.0f, 10.0f };
     camera.target = Vector3{ 0.0f, 0.0f, 0.0f };
@@ -37,178 +48,237 @@ void Player::Init() {
 }
 
 /**
- * updates position, physics, and camera view
+ * puts the player's feet on the real surface (caves and trees included)
+ */
+void Player::PlaceOnSurface(ChunkManager& world) {
+    int x = (int)floor(position.x);
+    int z = (int)floor(position.z);
+    position.y = (float)world.GetSurfaceHeight(x, z) + 1.0f + EYE_HEIGHT;
+    verticalVelocity = 0.0f;
+}
+
+/**
+ * copy of the blocks around the player for one physics step.
+ * unloaded chunks count as solid so the player waits at the edge of the
+ * loaded world instead of falling through it (or generating it mid-frame),
+ * below the world is solid too
  */
-void Player::Update(float dt, ChunkManager& world) {
+struct SolidGrid {
+    int minX, minY, minZ;
+    int sizeX, sizeY, sizeZ;
+    std::vector<BlockType> blocks;
+
+    bool At(int x, int y, int z) const {
+        if (y < 0) return true;
+        return IsSolid(blocks[((x - minX) * sizeY + (y - minY)) * sizeZ + (z - minZ)]);
+    }
+};
+
+static void GatherSolids(ChunkManager& world, int minX, int minY, int minZ, int maxX, int maxY, int maxZ, SolidGrid& grid) {
+    grid.minX = minX; grid.minY = minY; grid.minZ = minZ;
+    grid.sizeX = maxX - minX + 1;
+    grid.sizeY = maxY - minY + 1;
+    grid.sizeZ = maxZ - minZ + 1;
+
+    BlockAccessor accessor(world);
+    accessor.CopyRegion(minX, minY, minZ, maxX, maxY, maxZ, grid.blocks, BlockType::STONE);
+}
+
+/**
+ * how far the box [lo, hi] can move by delta along one axis before it
+ * touches a solid block. blocks it already overlaps are ignored so the
+ * player can always walk out of something placed inside it
+ */
+static float SweepAxis(const SolidGrid& grid, const float lo[3], const float hi[3], int axis, float delta) {
+    const float skin = 1e-4f;
+    int a = (axis + 1) % 3, b = (axis + 2) % 3;
+    int minCell[3] = { grid.minX, grid.minY, grid.minZ };
+    int maxCell[3] = { grid.minX + grid.sizeX - 1, grid.minY + grid.sizeY - 1, grid.minZ + grid.sizeZ - 1 };
+
+    // only blocks the box overlaps on the other two axes can stop it
+    int fromA = (int)floorf(lo[a] + skin), toA = (int)floorf(hi[a] - skin);
+    int fromB = (int)floorf(lo[b] + skin), toB = (int)floorf(hi[b] - skin);
+    if (fromA < minCell[a]) fromA = minCell[a];
+    if (toA > maxCell[a]) toA = maxCell[a];
+    if (fromB < minCell[b]) fromB = minCell[b];
+    if (toB > maxCell[b]) toB = maxCell[b];
+
+    int from, to;
+    if (delta > 0.0f) {
+        from = (int)floorf(hi[axis] - skin) + 1;
+        to = (int)floorf(hi[axis] + delta);
+    } else {
+        from = (int)floorf(lo[axis] + delta);
+        to = (int)floorf(lo[axis] + skin) - 1;
+    }
+    if (from < minCell[axis]) from = minCell[axis];
+    if (to > maxCell[axis]) to = maxCell[axis];
+
+    int cell[3];
+    for (cell[axis] = from; cell[axis] <= to; cell[axis]++) {
+        for (cell[a] = fromA; cell[a] <= toA; cell[a]++) {
+            for (cell[b] = fromB; cell[b] <= toB; cell[b]++) {
+                if (!grid.At(cell[0], cell[1], cell[2])) continue;
+                if (delta > 0.0f) {
+                    float limit = (float)cell[axis] - hi[axis];
+                    if (limit < delta) delta = limit > 0.0f ? limit : 0.0f;
+                } else {
+                    float limit = (float)cell[axis] + 1.0f - lo[axis];
+                    if (limit > delta) delta = limit < 0.0f ? limit : 0.0f;
+                }
+            }
+        }
+    }
+    return delta;
+}
+
+/**
+ * moves the player box by `move`, one axis at a time (vertical first so
+ * walking off a ledge and landing resolve the same way every step),
+ * and returns the movement that actually happened
+ */
+static Vector3 MoveAndCollide(ChunkManager& world, Vector3& eye, Vector3 move) {
+    float lo[3] = { eye.x - PLAYER_HALF_WIDTH, eye.y - EYE_HEIGHT, eye.z - PLAYER_HALF_WIDTH };
+    float hi[3] = { eye.x + PLAYER_HALF_WIDTH, eye.y - EYE_HEIGHT + PLAYER_HEIGHT, eye.z + PLAYER_HALF_WIDTH };
+    float d[3] = { move.x, move.y, move.z };
+
+    // every block the box can touch during this step, looked up once
+    int minCell[3], maxCell[3];
+    for (int axis = 0; axis < 3; axis++) {
+        minCell[axis] = (int)floorf(lo[axis] + (d[axis] < 0.0f ? d[axis] : 0.0f));
+        maxCell[axis] = (int)floorf(hi[axis] + (d[axis] > 0.0f ? d[axis] : 0.0f));
+    }
+    SolidGrid grid;
+    GatherSolids(world, minCell[0], minCell[1], minCell[2], maxCell[0], maxCell[1], maxCell[2], grid);
+
+    const int order[3] = { 1, 0, 2 };
+    for (int axis : order) {
+        if (d[axis] == 0.0f) continue;
+        d[axis] = SweepAxis(grid, lo, hi, axis, d[axis]);
+        lo[axis] += d[axis];
+        hi[axis] += d[axis];
+    }
+
+    eye.x += d[0];
+    eye.y += d[1];
+    eye.z += d[2];
+    return Vector3{ d[0], d[1], d[2] };
+}
+
+/**
+ * updates look direction, runs the physics steps and places the camera
+ */
+void Player::Update(float dt, ChunkManager& world, const InputFrame& input) {
     if (dt > 0.05f) dt = 0.05f; // cap timestep
 
     // mouse look
-    Vector2 mouseDelta = GetMouseDelta();
-    cameraAngleX -= mouseDelta.x * 0.003f;
-    cameraAngleY -= mouseDelta.y * 0.003f;
+    cameraAngleX -= input.mouseDX * 0.003f;
+    cameraAngleY -= input.mouseDY * 0.003f;
     if (cameraAngleY > 1.5f) cameraAngleY = 1.5f;
     if (cameraAngleY < -1.5f) cameraAngleY = -1.5f;
 
     forward = { sinf(cameraAngleX), 0.0f, cosf(cameraAngleX) };
     right = { cosf(cameraAngleX), 0.0f, -sinf(cameraAngleX) };
 
+    if (input.IsPressed(INPUT_TOGGLE_FLY)) isFlying = !isFlying;
+
+    // fixed steps, so jumps and speeds don't depend on the frame rate
+    Vector3 start = position;
+    physicsAccumulator += dt;
+    while (physicsAccumulator >= PLAYER_STEP) {
+        physicsAccumulator -= PLAYER_STEP;
+        Step(PLAYER_STEP, world, input);
+    }
+    velocity = dt > 0.0f ? Vector3Scale(Vector3Subtract(position, start), 1.0f / dt) : Vector3{ 0, 0, 0 };
+
+    camera.position = position;
+    Vector3 lookDir = {
+        sinf(cameraAngleX) * cosf(cameraAngleY),
+        sinf(cameraAngleY),
+        cosf(cameraAngleX) * cosf(cameraAngleY)
+    };
+    camera.target.x = camera.position.x + lookDir.x;
+    camera.target.y = camera.position.y + lookDir.y;
+    camera.target.z = camera.position.z + lookDir.z;
+}
+
+void Player::Step(float dt, ChunkManager& world, const InputFrame& input) {
     float baseSpeed = isFlying ? flySpeed : moveSpeed;
-    if (IsKeyDown(KEY_LEFT_SHIFT)) baseSpeed *= 2.0f;
+    if (input.IsHeld(INPUT_SPRINT)) baseSpeed *= 2.0f;
     float step = baseSpeed * dt;
 
     Vector3 moveVec = { 0,0,0 };
-    if (IsKeyDown(KEY_W)) { moveVec.x += forward.x; moveVec.z += forward.z; }
-    if (IsKeyDown(KEY_S)) { moveVec.x -= forward.x; moveVec.z -= forward.z; }
-    if (IsKeyDown(KEY_D)) { moveVec.x -= right.x; moveVec.z -= right.z; }
-    if (IsKeyDown(KEY_A)) { moveVec.x += right.x; moveVec.z += right.z; }
+    if (input.IsHeld(INPUT_FORWARD)) { moveVec.x += forward.x; moveVec.z += forward.z; }
+    if (input.IsHeld(INPUT_BACK)) { moveVec.x -= forward.x; moveVec.z -= forward.z; }
+    if (input.IsHeld(INPUT_RIGHT)) { moveVec.x -= right.x; moveVec.z -= right.z; }
+    if (input.IsHeld(INPUT_LEFT)) { moveVec.x += right.x; moveVec.z += right.z; }
 
     if (Vector3Length(moveVec) > 0) {
         moveVec = Vector3Normalize(moveVec);
         moveVec = Vector3Scale(moveVec, step);
     }
 
-    if (IsKeyPressed(KEY_F)) isFlying = !isFlying;
-
-    // physics application
+    // flying is free movement (no collision)
     if (isFlying) {
         position.x += moveVec.x;
         position.z += moveVec.z;
-        if (IsKeyDown(KEY_SPACE)) position.y += step;
-        if (IsKeyDown(KEY_LEFT_CONTROL)) position.y -= step;
+        if (input.IsHeld(INPUT_JUMP)) position.y += step;
+        if (input.IsHeld(INPUT_DOWN)) position.y -= step;
         verticalVelocity = 0.0f;
-    } else {
-        float dtScale = dt * 150.0f;
-        verticalVelocity -= gravity * dtScale;
-        if (verticalVelocity < -0.5f) verticalVelocity = -0.5f;
-
-        position.y += verticalVelocity * dtScale;
-
-        // collision checks
-        float playerHeight = 1.5f;
-        // float playerWidth = 0.3f; // unused variables removed
-
-        if (verticalVelocity <= 0.0f) {
-            bool onGround = false;
-            float lowestY = position.y - playerHeight;
-
-            for (int dx = 0; dx <= 1; dx++) {
-                for (int dz = 0; dz <= 1; dz++) {
-                    int checkX = (int)floor(position.x + (dx * 0.5f));
-                    int checkZ = (int)floor(position.z + (dz * 0.5f));
-                    int checkY = (int)floor(lowestY - 0.1f);
-
-                    if (world.GetBlock(checkX, checkY, checkZ) != BlockType::AIR) {
-                        float blockTop = (float)checkY + 1.0f;
-                        if (lowestY - 0.1f < blockTop) {
-                            position.y = blockTop + playerHeight;
-                            onGround = true;
-                        }
-                    }
-                }
-            }
-
-            if (onGround) {
-                verticalVelocity = 0.0f;
-                if (IsKeyDown(KEY_SPACE)) verticalVelocity = jumpForce;
-            }
-        }
-
-        // horizontal collision
-        float playerWidth = 0.3f;
-        Vector3 testPos = position;
-        testPos.x += moveVec.x;
+        onGround = false;
+        return;
+    }
 
-        int wallX = (int)floor(testPos.x + (moveVec.x > 0 ? playerWidth : -playerWidth));
-        int kneeY = (int)floor(position.y - 1.0f);
-        int headY = (int)floor(position.y - 0.2f);
-        int footZ = (int)floor(position.z);
+    if (onGround && input.IsHeld(INPUT_JUMP)) verticalVelocity = jumpForce;
 
-        if (world.GetBlock(wallX, kneeY, footZ) == BlockType::AIR && world.GetBlock(wallX, headY, footZ) == BlockType::AIR) {
-            position.x += moveVec.x;
-        }
+    float dtScale = dt * 150.0f;
+    verticalVelocity -= gravity * dtScale;
+    if (verticalVelocity < -0.5f) verticalVelocity = -0.5f;
 
-        testPos = position;
-        testPos.z += moveVec.z;
-        int wallZ = (int)floor(testPos.z + (moveVec.z > 0 ? playerWidth : -playerWidth));
-        int currentFootX = (int)floor(position.x);
+    Vector3 wanted = { moveVec.x, verticalVelocity * dtScale, moveVec.z };
+    Vector3 moved = MoveAndCollide(world, position, wanted);
 
-        if (world.GetBlock(currentFootX, kneeY, wallZ) == BlockType::AIR && world.GetBlock(currentFootX, headY, wallZ) == BlockType::AIR) {
-            position.z += moveVec.z;
-        }
-    }
-
-    camera.position = position;
-    Vector3 lookDir = {
-        sinf(cameraAngleX) * cosf(cameraAngleY),
-        sinf(cameraAngleY),
-        cosf(cameraAngleX) * cosf(cameraAngleY)
-    };
-    camera.target.x = camera.position.x + lookDir.x;
-    camera.target.y = camera.position.y + lookDir.y;
-    camera.target.z = camera.position.z + lookDir.z;
+    // landed or bumped the head
+    onGround = wanted.y < 0.0f && moved.y > wanted.y;
+    if (moved.y != wanted.y) verticalVelocity = 0.0f;
 }
 
 /**
  * casts a ray from the camera to detect selected block
  */
 void Player::UpdateRaycast(ChunkManager& world) {
-    isBlockSelected = false;
-    Ray ray = GetMouseRay(Vector2{ (float)GetScreenWidth() / 2, (float)GetScreenHeight() / 2 }, camera);
-    float closestDist = 8.0f;
-
-    int radius = 6;
-    int camX = (int)floor(camera.position.x);
-    int camY = (int)floor(camera.position.y);
-    int camZ = (int)floor(camera.position.z);
-
-    for (int x = camX - radius; x <= camX + radius; x++) {
-        for (int y = camY - radius; y <= camY + radius; y++) {
-            for (int z = camZ - radius; z <= camZ + radius; z++) {
-                if (world.GetBlock(x, y, z, false) == BlockType::AIR) continue;
-
-                Vector3 min = { (float)x, (float)y, (float)z };
-                Vector3 max = { (float)x + 1.0f, (float)y + 1.0f, (float)z + 1.0f };
-                BoundingBox box = { min, max };
-
-                RayCollision collision = GetRayCollisionBox(ray, box);
-                if (collision.hit && collision.distance < closestDist) {
-                    isBlockSelected = true;
-                    closestDist = collision.distance;
-                    selectedBlockPos = Vector3{ (float)x, (float)y, (float)z };
-                    selectedNormal = collision.normal;
-                }
-            }
-        }
+    // straight out of the camera (same as the screen-centre ray, but needs no window)
+    Vector3 direction = Vector3Subtract(camera.target, camera.position);
+    VoxelHit hit = RaycastBlocks(world, camera.position, direction, reachDistance);
+
+    isBlockSelected = hit.hit;
+    if (hit.hit) {
+        selectedBlockPos = Vector3{ (float)hit.x, (float)hit.y, (float)hit.z };
+        selectedNormal = Vector3{ (float)hit.normalX, (float)hit.normalY, (float)hit.normalZ };
     }
 }
 
 /**
  * processes keyboard and mouse input for interaction
  */
-void Player::HandleInput(ChunkManager& world) {
+void Player::HandleInput(ChunkManager& world, const InputFrame& input) {
     // select hotbar
-    if (IsKeyPressed(KEY_ONE))   inventory.selectedSlot = 0;
-    if (IsKeyPressed(KEY_TWO))   inventory.selectedSlot = 1;
-    if (IsKeyPressed(KEY_THREE)) inventory.selectedSlot = 2;
-    if (IsKeyPressed(KEY_FOUR))  inventory.selectedSlot = 3;
-    if (IsKeyPressed(KEY_FIVE))  inventory.selectedSlot = 4;
-    if (IsKeyPressed(KEY_SIX))   inventory.selectedSlot = 5;
-    if (IsKeyPressed(KEY_SEVEN)) inventory.selectedSlot = 6;
-    if (IsKeyPressed(KEY_EIGHT)) inventory.selectedSlot = 7;
-    if (IsKeyPressed(KEY_NINE))  inventory.selectedSlot = 8;
-
-    float wheel = GetMouseWheelMove();
+    for (int i = 0; i < 9; i++) {
+        if (input.IsPressed(INPUT_SLOT_1 << i)) inventory.selectedSlot = i;
+    }
+
+    float wheel = input.wheel;
     if (wheel > 0) inventory.selectedSlot--;
     if (wheel < 0) inventory.selectedSlot++;
     if (inventory.selectedSlot < 0) inventory.selectedSlot = 8;
     if (inventory.selectedSlot > 8) inventory.selectedSlot = 0;
 
     if (isBlockSelected) {
-        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+        if (input.IsPressed(INPUT_BREAK)) {
             world.SetBlock((int)selectedBlockPos.x, (int)selectedBlockPos.y, (int)selectedBlockPos.z, BlockType::AIR);
             UpdateRaycast(world);
         }
-        if (IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)) {
+        if (input.IsPressed(INPUT_PLACE)) {
             int currentID = GetHeldBlockID();
             if (currentID != 0) {
                 int newX = (int)(selectedBlockPos.x + round(selectedNormal.x));
@@ -221,5 +291,9 @@ void Player::HandleInput(ChunkManager& world) {
                 }
             }
         }
+        if (input.IsPressed(INPUT_EXPLODE)) {
+            Explode(world, (int)selectedBlockPos.x, (int)selectedBlockPos.y, (int)selectedBlockPos.z, EXPLOSION_RADIUS);
+            UpdateRaycast(world);
+        }
     }
 }
\ No newline at end of file
@@ -4,6 +4,17 @@
 #include "raylib.h"
 #include "inventory.h"
 #include "../world/chunk_manager.h"
+#include "../core/input.h"
+
+// camera height above the player's feet
+#define EYE_HEIGHT 1.5f
+
+// collision box: 0.6 wide, feet to top of head
+#define PLAYER_HALF_WIDTH 0.3f
+#define PLAYER_HEIGHT 1.8f
+
+// fixed player physics step in seconds, frames run as many as fit
+#define PLAYER_STEP (1.0f / 120.0f)
 
 /**
  * controls the first person camera and player physics
@@ -22,6 +33,9 @@ public:
     float flySpeed;
     bool isFlying;
     float verticalVelocity;
+    Vector3 velocity; // movement over the last Update, blocks per second
+    bool onGround;
+    float physicsAccumulator; // frame time not yet simulated
     
     // camera orientation
     float cameraAngleX;
@@ -30,6 +44,7 @@ public:
     Vector3 right;
 
     // interaction state
+    float reachDistance;
     bool isBlockSelected;
     Vector3 selectedBlockPos;
     Vector3 selectedNormal;
@@ -37,23 +52,34 @@ public:
     void Init();
 
     /**
-     * updates physics and movement logic
+     * snaps the player onto the highest block of its column
      */
-    void Update(float dt, ChunkManager& world);
+    void PlaceOnSurface(ChunkManager& world);
 
     /**
-     * performs raycasting for block selection
+     * applies mouse look, then runs the fixed physics steps covered by dt
+     */
+    void Update(float dt, ChunkManager& world, const InputFrame& input);
+
+    /**
+     * selects the first solid block within reach under the crosshair
      */
     void UpdateRaycast(ChunkManager& world);
 
     /**
      * handles block breaking and placement input
      */
-    void HandleInput(ChunkManager& world); 
+    void HandleInput(ChunkManager& world, const InputFrame& input);
     
     int GetHeldBlockID() {
         return inventory.slots[inventory.selectedSlot].blockID;
     }
+
+private:
+    /**
+     * one PLAYER_STEP of movement, gravity and collision
+     */
+    void Step(float dt, ChunkManager& world, const InputFrame& input);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "block_accessor.h"
+#include "chunk_manager.h"
+
+Chunk* BlockAccessor::Lookup(int cx, int cz) {
+    if (!hasCached || cx != cachedX || cz != cachedZ) {
+        cached = world.FindChunk(cx, cz);
+        cachedX = cx;
+        cachedZ = cz;
+        hasCached = true;
+    }
+    return cached;
+}
+
+BlockType BlockAccessor::Get(int x, int y, int z) {
+    if (y < 0 || y >= CHUNK_SIZE) return BlockType::AIR;
+    int cx = ChunkOf(x), cz = ChunkOf(z);
+    Chunk* chunk = Lookup(cx, cz);
+    if (!chunk) return BlockType::AIR;
+    return chunk->blocks[x - cx * CHUNK_SIZE][y][z - cz * CHUNK_SIZE];
+}
+
+unsigned char BlockAccessor::GetLight(int x, int y, int z) {
+    if (y < 0 || y >= CHUNK_SIZE) return 0;
+    int cx = ChunkOf(x), cz = ChunkOf(z);
+    Chunk* chunk = Lookup(cx, cz);
+    if (!chunk) return 0;
+    return chunk->light[x - cx * CHUNK_SIZE][y][z - cz * CHUNK_SIZE];
+}
+
+bool BlockAccessor::IsLoaded(int x, int z) {
+    return Lookup(ChunkOf(x), ChunkOf(z)) != nullptr;
+}
+
+void BlockAccessor::Seek(int x, int y, int z) {
+    int cx = ChunkOf(x), cz = ChunkOf(z);
+    cursorChunk = Lookup(cx, cz);
+    cursor[0] = x; cursor[1] = y; cursor[2] = z;
+    local[0] = x - cx * CHUNK_SIZE;
+    local[1] = y;
+    local[2] = z - cz * CHUNK_SIZE;
+}
+
+void BlockAccessor::Move(int axis, int step) {
+    cursor[axis] += step;
+    local[axis] += step;
+    if (axis == 1) return; // y never leaves the chunk column
+
+    if (local[axis] < 0 || local[axis] >= CHUNK_SIZE) {
+        local[axis] -= step * CHUNK_SIZE;
+        cursorChunk = Lookup(ChunkOf(cursor[0]), ChunkOf(cursor[2]));
+    }
+}
+
+BlockType BlockAccessor::Current() const {
+    if (!cursorChunk || local[1] < 0 || local[1] >= CHUNK_SIZE) return BlockType::AIR;
+    return cursorChunk->blocks[local[0]][local[1]][local[2]];
+}
+
+void BlockAccessor::CopyRegion(int minX, int minY, int minZ, int maxX, int maxY, int maxZ,
+    std::vector<BlockType>& out, BlockType unloaded) {
+    int sizeY = maxY - minY + 1;
+    int sizeZ = maxZ - minZ + 1;
+    out.assign((size_t)(maxX - minX + 1) * sizeY * sizeZ, BlockType::AIR);
+
+    // the part of the box inside the world height
+    int fromY = minY < 0 ? 0 : minY;
+    int toY = maxY >= CHUNK_SIZE ? CHUNK_SIZE - 1 : maxY;
+
+    for (int x = minX; x <= maxX; x++) {
+        int cx = ChunkOf(x);
+        int lx = x - cx * CHUNK_SIZE;
+
+        // z runs are contiguous in both layouts, copy them chunk by chunk
+        for (int z = minZ; z <= maxZ;) {
+            int cz = ChunkOf(z);
+            int lz = z - cz * CHUNK_SIZE;
+            int run = CHUNK_SIZE - lz;
+            if (run > maxZ - z + 1) run = maxZ - z + 1;
+
+            Chunk* chunk = Lookup(cx, cz);
+            for (int y = fromY; y <= toY; y++) {
+                BlockType* dst = &out[((size_t)(x - minX) * sizeY + (y - minY)) * sizeZ + (z - minZ)];
+                if (chunk) memcpy(dst, &chunk->blocks[lx][y][lz], run * sizeof(BlockType));
+                else for (int i = 0; i < run; i++) dst[i] = unloaded;
+            }
+            z += run;
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef BLOCK_ACCESSOR_H
+#define BLOCK_ACCESSOR_H
+
+#include "../core/constants.h"
+#include "../blocks/block_types.h"
+#include <vector>
+
+class ChunkManager;
+struct Chunk;
+
+/**
+ * floor division by CHUNK_SIZE (chunk coordinate of a world coordinate)
+ */
+inline int ChunkOf(int v) {
+    return v >= 0 ? v / CHUNK_SIZE : (v + 1) / CHUNK_SIZE - 1;
+}
+
+/**
+ * fast reads for code that touches many nearby blocks (collision, raycasts,
+ * block behaviours). remembers the chunk it last read from, so neighbouring
+ * reads skip the chunk map, and a cursor can step one block at a time.
+ * never generates chunks: unloaded chunks and anything above or below the
+ * world read as AIR with no light.
+ * only valid while no chunk is added or removed.
+ */
+class BlockAccessor {
+public:
+    explicit BlockAccessor(ChunkManager& world) : world(world) {}
+
+    BlockType Get(int x, int y, int z);
+    unsigned char GetLight(int x, int y, int z); // packed sun/torch
+    bool IsLoaded(int x, int z);
+
+    /**
+     * cursor: Seek to a block, then Move one block at a time along an axis
+     * (0 = x, 1 = y, 2 = z, step -1 or 1). only crossing into another chunk
+     * costs a lookup
+     */
+    void Seek(int x, int y, int z);
+    void Move(int axis, int step);
+    BlockType Current() const;
+    bool CurrentLoaded() const { return cursorChunk != nullptr; }
+
+    /**
+     * copies the inclusive box [min, max] into out, indexed like Chunk::blocks
+     * ((x * sizeY + y) * sizeZ + z, relative to min). callers pad the box
+     * themselves. unloaded cells get `unloaded`, cells above or below the
+     * world get AIR
+     */
+    void CopyRegion(int minX, int minY, int minZ, int maxX, int maxY, int maxZ,
+        std::vector<BlockType>& out, BlockType unloaded = BlockType::AIR);
+
+private:
+    ChunkManager& world;
+
+    // last chunk looked up (found may be nullptr: known to be unloaded)
+    int cachedX = 0, cachedZ = 0;
+    Chunk* cached = nullptr;
+    bool hasCached = false;
+
+    Chunk* Lookup(int cx, int cz);
+
+    // cursor state: world position plus its chunk and local coordinates
+    int cursor[3] = { 0, 0, 0 };
+    int local[3] = { 0, 0, 0 };
+    Chunk* cursorChunk = nullptr;
+};
+
+#endif
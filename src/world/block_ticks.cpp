@@ -0,0 +1,82 @@
+#include "block_ticks.h"
+#include "chunk_manager.h"
+#include "block_accessor.h"
+
+void BlockTickScheduler::Reset() {
+    queue = {};
+    currentTick = 0;
+    nextOrder = 0;
+    rngState = 2463534242u;
+}
+
+void BlockTickScheduler::RegisterScheduled(BlockType type, BlockBehaviour behaviour, int delayTicks) {
+    scheduledBehaviours[(int)type] = behaviour;
+    delays[(int)type] = delayTicks;
+}
+
+void BlockTickScheduler::RegisterRandom(BlockType type, BlockBehaviour behaviour) {
+    randomBehaviours[(int)type] = behaviour;
+}
+
+void BlockTickScheduler::Schedule(BlockType type, int x, int y, int z) {
+    if (!scheduledBehaviours[(int)type]) return;
+    queue.push({ currentTick + delays[(int)type], nextOrder++, x, y, z });
+}
+
+int BlockTickScheduler::RunDue(ChunkManager& world, int maxRuns) {
+    int runs = 0;
+    // only loaded chunks are read, a tick queued in a chunk that went cold
+    // since is dropped (nothing simulates out there)
+    BlockAccessor blocks(world);
+    while (!queue.empty() && runs < maxRuns && queue.top().due <= currentTick) {
+        ScheduledTick tick = queue.top();
+        queue.pop();
+        runs++;
+
+        // the block may have changed since it was queued
+        BlockBehaviour behaviour = scheduledBehaviours[(int)blocks.Get(tick.x, tick.y, tick.z)];
+        if (behaviour) behaviour(world, tick.x, tick.y, tick.z);
+    }
+    return runs;
+}
+
+unsigned int BlockTickScheduler::NextRandom() {
+    // xorshift32, same sequence for the same edit history
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+/**
+ * grass needs light: anything opaque (or water) on top turns it back to dirt
+ */
+static void GrassTick(ChunkManager& world, int x, int y, int z) {
+    if (y + 1 < CHUNK_SIZE && BlocksSunlight(world.GetBlock(x, y + 1, z, false))) {
+        world.SetBlock(x, y, z, BlockType::DIRT);
+    }
+}
+
+/**
+ * uncovered dirt next to grass (one block up or down) grows grass
+ */
+static void DirtTick(ChunkManager& world, int x, int y, int z) {
+    BlockAccessor blocks(world);
+    if (blocks.Get(x, y + 1, z) != BlockType::AIR) return;
+
+    static const int offsets[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+    for (int i = 0; i < 4; i++) {
+        for (int dy = -1; dy <= 1; dy++) {
+            if (blocks.Get(x + offsets[i][0], y + dy, z + offsets[i][1]) == BlockType::GRASS) {
+                world.SetBlock(x, y, z, BlockType::GRASS);
+                return;
+            }
+        }
+    }
+}
+
+void RegisterDefaultBehaviours(BlockTickScheduler& ticks) {
+    ticks.RegisterScheduled(BlockType::GRASS, GrassTick, 20); // one second after being covered
+    ticks.RegisterRandom(BlockType::GRASS, GrassTick);
+    ticks.RegisterRandom(BlockType::DIRT, DirtTick);
+}
@@ -0,0 +1,92 @@
+#ifndef BLOCK_TICKS_H
+#define BLOCK_TICKS_H
+
+#include "../blocks/block_types.h"
+#include <queue>
+#include <vector>
+#include <functional>
+
+class ChunkManager;
+
+// random ticks per non-empty 16^3 section per tick
+#define RANDOM_TICKS_PER_SECTION 3
+
+// behaviour calls + random samples allowed per tick
+#define DEFAULT_TICK_BUDGET 8192
+
+/**
+ * a block behaviour, called with world coordinates
+ */
+typedef void (*BlockBehaviour)(ChunkManager& world, int x, int y, int z);
+
+/**
+ * pending scheduled update, ordered by due tick then by insertion
+ */
+struct ScheduledTick {
+    long long due;
+    unsigned int order;
+    int x, y, z;
+
+    bool operator>(const ScheduledTick& other) const {
+        if (due != other.due) return due > other.due;
+        return order > other.order;
+    }
+};
+
+/**
+ * registry and queue for block behaviours
+ * scheduled behaviours run a fixed delay after something next to the block
+ * changes, random behaviours run when the random-tick sampler lands on the block
+ * (the sampler itself lives in ChunkManager::UpdateBlockTicks)
+ */
+class BlockTickScheduler {
+public:
+    int budget = DEFAULT_TICK_BUDGET;
+
+    /**
+     * clears pending ticks and restarts the random sequence
+     */
+    void Reset();
+
+    void RegisterScheduled(BlockType type, BlockBehaviour behaviour, int delayTicks);
+    void RegisterRandom(BlockType type, BlockBehaviour behaviour);
+
+    BlockBehaviour GetRandomBehaviour(BlockType type) const { return randomBehaviours[(int)type]; }
+
+    /**
+     * queues the scheduled behaviour of `type` at (x, y, z) after its delay
+     * (does nothing for types without one)
+     */
+    void Schedule(BlockType type, int x, int y, int z);
+
+    /**
+     * runs due scheduled ticks (the block must still have a scheduled behaviour)
+     * returns how much of the budget was used
+     */
+    int RunDue(ChunkManager& world, int maxRuns);
+
+    /**
+     * ends the current tick
+     */
+    void Advance() { currentTick++; }
+
+    unsigned int NextRandom();
+    int GetQueuedCount() const { return (int)queue.size(); }
+
+private:
+    BlockBehaviour scheduledBehaviours[(int)BlockType::COUNT] = {};
+    BlockBehaviour randomBehaviours[(int)BlockType::COUNT] = {};
+    int delays[(int)BlockType::COUNT] = {};
+
+    std::priority_queue<ScheduledTick, std::vector<ScheduledTick>, std::greater<ScheduledTick>> queue;
+    long long currentTick = 0;
+    unsigned int nextOrder = 0;
+    unsigned int rngState = 1;
+};
+
+/**
+ * grass decay/spread and other built-in behaviours
+ */
+void RegisterDefaultBehaviours(BlockTickScheduler& ticks);
+
+#endif
@@ -0,0 +1,27 @@
+#include "chunk_codec.h"
+#include <cstring>
+
+void RleEncode(const unsigned char* data, size_t size, std::vector<unsigned char>& out) {
+    size_t i = 0;
+    while (i < size) {
+        unsigned char value = data[i];
+        size_t run = 1;
+        while (run < 256 && i + run < size && data[i + run] == value) run++;
+        out.push_back(value);
+        out.push_back((unsigned char)(run - 1));
+        i += run;
+    }
+}
+
+size_t RleDecode(const std::vector<unsigned char>& in, size_t pos, unsigned char* out, size_t size) {
+    size_t written = 0;
+    while (written < size) {
+        if (pos + 2 > in.size()) return 0;
+        size_t run = (size_t)in[pos + 1] + 1;
+        if (run > size - written) return 0;
+        memset(out + written, in[pos], run);
+        written += run;
+        pos += 2;
+    }
+    return pos;
+}
@@ -0,0 +1,24 @@
+#ifndef CHUNK_CODEC_H
+#define CHUNK_CODEC_H
+
+#include <vector>
+#include <cstddef>
+
+/**
+ * run-length coding for chunks parked in memory: (value, run length - 1)
+ * byte pairs. chunk arrays are long runs of air, stone and full sunlight,
+ * so this is small and fast enough to undo on the main thread
+ */
+
+/**
+ * appends `size` bytes of `data` to `out`
+ */
+void RleEncode(const unsigned char* data, size_t size, std::vector<unsigned char>& out);
+
+/**
+ * expands `size` bytes from `in` starting at `pos` into `out`
+ * returns the position after them, or 0 if `in` ends first
+ */
+size_t RleDecode(const std::vector<unsigned char>& in, size_t pos, unsigned char* out, size_t size);
+
+#endif
@@ -1,5 +1,9 @@
 #include "chunk_manager.h"
 #include "world_generator.h"
+#include "block_accessor.h"
+#include "chunk_codec.h"
+#include "../core/profiler.h"
+#include "../core/job_system.h"
 #include "raymath.h"
 #include "rlgl.h"
 #include "../blocks/block_types.h"
@@ -7,14 +11,152 @@
 #include <vector>
 #include <cstring>
 #include <queue>
+#include <algorithm>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// active cell keys: column-major with y innermost, so sorting puts each
+// column's cells together from the bottom up
+static inline uint32_t PackCell(int x, int y, int z) {
+    return (uint32_t)((x * CHUNK_SIZE + z) * CHUNK_SIZE + y);
+}
+
+static inline int SectionIndex(int x, int y, int z) {
+    return ((x / SECTION_SIZE) * SECTIONS_PER_AXIS + y / SECTION_SIZE) * SECTIONS_PER_AXIS + z / SECTION_SIZE;
+}
+
+// index of the lowest set bit (bits must not be 0)
+static inline int LowestBit(uint64_t bits) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (int)index;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+static inline int PopCount(uint64_t bits) {
+    int count = 0;
+    for (; bits; bits &= bits - 1) count++;
+    return count;
+}
 
-void ChunkManager::Init() {}
+/**
+ * recomputes one column's occupancy bits from its blocks
+ */
+static void RebuildColumn(Chunk& chunk, int x, int z) {
+    uint64_t blockBits = 0;
+    uint64_t waterBits = 0;
+    for (int y = 0; y <= chunk.heightMap[x][z]; y++) {
+        BlockType type = chunk.blocks[x][y][z];
+        if (type == BlockType::WATER) waterBits |= 1ull << y;
+        else if (type != BlockType::AIR) blockBits |= 1ull << y;
+    }
+    chunk.blockColumns[x][z] = blockBits;
+    chunk.waterColumns[x][z] = waterBits;
+}
+
+/**
+ * writes one block and keeps the section counts, occupancy bits, heightmap
+ * and sun height exact
+ * (any water level stored for the cell is dropped, new water is a source)
+ */
+static void WriteBlock(Chunk& chunk, int x, int y, int z, BlockType type) {
+    BlockType previous = chunk.blocks[x][y][z];
+    chunk.blocks[x][y][z] = type;
+    if (previous == BlockType::WATER) chunk.fluidLevels.erase(PackCell(x, y, z));
+
+    uint64_t bit = 1ull << y;
+    chunk.blockColumns[x][z] &= ~bit;
+    chunk.waterColumns[x][z] &= ~bit;
+    if (type == BlockType::WATER) chunk.waterColumns[x][z] |= bit;
+    else if (type != BlockType::AIR) chunk.blockColumns[x][z] |= bit;
+
+    if ((previous == BlockType::AIR) != (type == BlockType::AIR)) {
+        chunk.sectionCounts[SectionIndex(x, y, z)] += type == BlockType::AIR ? -1 : 1;
+    }
+
+    unsigned char& top = chunk.heightMap[x][z];
+    if (type != BlockType::AIR) {
+        if (y > top) top = (unsigned char)y;
+    }
+    else if (y == top) {
+        while (top > 0 && chunk.blocks[x][top][z] == BlockType::AIR) top--;
+    }
+
+    unsigned char& sun = chunk.sunHeight[x][z];
+    if (BlocksSunlight(type)) {
+        if (y >= sun) sun = (unsigned char)(y + 1);
+    }
+    else if (y == sun - 1) {
+        while (sun > 0 && !BlocksSunlight(chunk.blocks[x][sun - 1][z])) sun--;
+    }
+}
+
+void ChunkManager::Init() {
+    RegisterDefaultBehaviours(ticks);
+    ticks.Reset();
+}
 
 void ChunkManager::UnloadAll() {
     for (auto& pair : chunks) {
-        UnloadChunkModels(pair.second);
+        UnloadChunkModels(*pair.second);
+        pool.Release(pair.second);
     }
     chunks.clear();
+    coldChunks.clear();
+    coldOrder.clear();
+    coldBytes = 0;
+    activeChunks.clear();
+    fluidChunks.clear();
+    fluidTickCounter = 0;
+    ticks.Reset();
+    randomTickCursor = { 0, 0 };
+    scheduleRadius = -1;
+    prefetchQueue.clear();
+    prefetchPath.clear();
+    prefetchHeading = { 0, 0, 0 };
+    stats = {};
+}
+
+void Chunk::Reset() {
+    dirtySections = ALL_SECTIONS;
+    borderFixPending = false;
+    neighbourMask = 0;
+    state = ChunkState::WAITING;
+    modified = false;
+    requestTime = 0.0;
+    hasBeenDrawn = false;
+    gpuBytes = 0;
+    meshData.Clear();
+    memset(sectionFaces, 0, sizeof(sectionFaces));
+    activeCells.clear();
+    fluidLevels.clear();
+    fluidFrontier.clear();
+    memset(heightMap, 0, sizeof(heightMap));
+    memset(biomeMap, 0, sizeof(biomeMap));
+    memset(sunHeight, 0, sizeof(sunHeight));
+    memset(sectionCounts, 0, sizeof(sectionCounts));
+    memset(blockColumns, 0, sizeof(blockColumns));
+    memset(waterColumns, 0, sizeof(waterColumns));
+}
+
+Chunk* ChunkPool::Acquire() {
+    if (!freeList.empty()) {
+        Chunk* chunk = freeList.back();
+        freeList.pop_back();
+        return chunk;
+    }
+    storage.push_back(std::make_unique<Chunk>());
+    allocations++;
+    return storage.back().get();
+}
+
+void ChunkPool::Release(Chunk* chunk) {
+    chunk->Reset();
+    freeList.push_back(chunk);
 }
 
 /**
@@ -27,7 +169,7 @@ void ChunkManager::UnloadChunkModels(Chunk& chunk) {
             chunk.layers[i] = { 0 };
         }
     }
-    chunk.meshReady = false;
+    chunk.gpuBytes = 0;
 }
 
 /**
@@ -36,19 +178,17 @@ void ChunkManager::UnloadChunkModels(Chunk& chunk) {
 BlockType ChunkManager::GetBlock(int x, int y, int z, bool createIfMissing) {
     if (y < 0 || y >= CHUNK_SIZE) return BlockType::AIR;
 
-    int cx = (int)floor((float)x / CHUNK_SIZE);
-    int cz = (int)floor((float)z / CHUNK_SIZE);
-    ChunkCoord coord = { cx, cz };
+    int cx = ChunkOf(x);
+    int cz = ChunkOf(z);
 
-    if (chunks.find(coord) == chunks.end()) {
-        if (createIfMissing) GenerateChunk(chunks[coord], cx, cz);
+    Chunk* chunk = FindChunk(cx, cz);
+    if (!chunk) chunk = ThawChunk({ cx, cz });
+    if (!chunk) {
+        if (createIfMissing) chunk = &GetOrCreateChunk(cx, cz);
         else return BlockType::AIR;
     }
 
-    int lx = ((x % CHUNK_SIZE) + CHUNK_SIZE) % CHUNK_SIZE;
-    int lz = ((z % CHUNK_SIZE) + CHUNK_SIZE) % CHUNK_SIZE;
-
-    return chunks[coord].blocks[lx][y][lz];
+    return chunk->blocks[x - cx * CHUNK_SIZE][y][z - cz * CHUNK_SIZE];
 }
 
 /**
@@ -57,53 +197,322 @@ BlockType ChunkManager::GetBlock(int x, int y, int z, bool createIfMissing) {
 void ChunkManager::SetBlock(int x, int y, int z, BlockType type) {
     if (y < 0 || y >= CHUNK_SIZE) return;
 
-    int cx = (int)floor((float)x / CHUNK_SIZE);
-    int cz = (int)floor((float)z / CHUNK_SIZE);
-    ChunkCoord coord = { cx, cz };
+    int cx = ChunkOf(x);
+    int cz = ChunkOf(z);
 
-    if (chunks.find(coord) == chunks.end()) GenerateChunk(chunks[coord], cx, cz);
+    int lx = x - cx * CHUNK_SIZE;
+    int lz = z - cz * CHUNK_SIZE;
 
-    int lx = ((x % CHUNK_SIZE) + CHUNK_SIZE) % CHUNK_SIZE;
-    int lz = ((z % CHUNK_SIZE) + CHUNK_SIZE) % CHUNK_SIZE;
+    BeginEdit();
 
     // update the block
-    chunks[coord].blocks[lx][y][lz] = type;
+    Chunk& chunk = GetOrCreateChunk(cx, cz);
+    WriteBlock(chunk, lx, y, lz, type);
+    if (!runningTicks) chunk.modified = true;
+
+    // the changed cell and whatever rests on it may fall now
+    ChunkCoord coord = { cx, cz };
+    ActivateCell(chunk, coord, lx, y, lz);
+    if (y + 1 < CHUNK_SIZE) ActivateCell(chunk, coord, lx, y + 1, lz);
+
+    ScheduleAround(x, y, z);
+    WakeFluids(x, y, z);
+
+    DirtyMasks dirty;
+    dirty.AddCell(lx, y, lz);
+    ApplyDirty(chunk, coord, dirty);
+    editRelight.insert(coord);
+
+    CommitEdit();
+}
+
+void ChunkManager::BeginEdit() {
+    editDepth++;
+}
+
+void ChunkManager::CommitEdit() {
+    if (editDepth == 0 || --editDepth > 0) return;
+
+    for (const ChunkCoord& coord : editRelight) {
+        Chunk* chunk = FindChunk(coord.x, coord.z);
+        if (!chunk) continue;
+        DirtyMasks dirty;
+        RelightTracked(*chunk, lightBefore, dirty);
+        ApplyDirty(*chunk, coord, dirty);
+    }
+    editRelight.clear();
+}
+
+void DirtyMasks::AddCell(int x, int y, int z) {
+    own |= 1ull << SectionIndex(x, y, z);
+
+    int edgeY = y % SECTION_SIZE;
+    if (edgeY == 0 && y > 0) own |= 1ull << SectionIndex(x, y - 1, z);
+    if (edgeY == SECTION_SIZE - 1 && y < CHUNK_SIZE - 1) own |= 1ull << SectionIndex(x, y + 1, z);
+
+    int edgeX = x % SECTION_SIZE;
+    if (edgeX == 0) {
+        if (x > 0) own |= 1ull << SectionIndex(x - 1, y, z);
+        else sides[1] |= 1ull << SectionIndex(CHUNK_SIZE - 1, y, z);
+    }
+    if (edgeX == SECTION_SIZE - 1) {
+        if (x < CHUNK_SIZE - 1) own |= 1ull << SectionIndex(x + 1, y, z);
+        else sides[0] |= 1ull << SectionIndex(0, y, z);
+    }
+
+    int edgeZ = z % SECTION_SIZE;
+    if (edgeZ == 0) {
+        if (z > 0) own |= 1ull << SectionIndex(x, y, z - 1);
+        else sides[3] |= 1ull << SectionIndex(x, y, CHUNK_SIZE - 1);
+    }
+    if (edgeZ == SECTION_SIZE - 1) {
+        if (z < CHUNK_SIZE - 1) own |= 1ull << SectionIndex(x, y, z + 1);
+        else sides[2] |= 1ull << SectionIndex(x, y, 0);
+    }
+}
+
+/**
+ * relights a chunk and adds every cell whose light changed to `dirty`
+ * (face colours come from the light of the cell in front of the face).
+ * touches nothing but the chunk, so fluid jobs can run it in parallel
+ */
+void ChunkManager::RelightTracked(Chunk& chunk, std::vector<unsigned char>& scratch, DirtyMasks& dirty) {
+    scratch.resize(sizeof(chunk.light));
+    memcpy(scratch.data(), chunk.light, sizeof(chunk.light));
 
-    // recalculate lighting
-    ComputeChunkLighting(chunks[coord]);
+    ComputeChunkLighting(chunk);
+
+    // compare 8 cells at a time, most of the chunk is unchanged
+    const unsigned char* before = scratch.data();
+    const unsigned char* after = &chunk.light[0][0][0];
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int y = 0; y < CHUNK_SIZE; y++) {
+            size_t row = ((size_t)x * CHUNK_SIZE + y) * CHUNK_SIZE;
+            for (int z = 0; z < CHUNK_SIZE; z += 8) {
+                uint64_t a, b;
+                memcpy(&a, before + row + z, 8);
+                memcpy(&b, after + row + z, 8);
+                if (a == b) continue;
+                for (int i = 0; i < 8; i++) {
+                    if (before[row + z + i] != after[row + z + i]) dirty.AddCell(x, y, z + i);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * hands the dirty bits to the chunk and its loaded neighbours
+ */
+void ChunkManager::ApplyDirty(Chunk& chunk, ChunkCoord coord, const DirtyMasks& dirty) {
+    chunk.dirtySections |= dirty.own;
+    static const int sides[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+    for (int i = 0; i < 4; i++) {
+        if (!dirty.sides[i]) continue;
+        Chunk* other = FindChunk(coord.x + sides[i][0], coord.z + sides[i][1]);
+        if (other) other->dirtySections |= dirty.sides[i];
+    }
+}
+
+Chunk* ChunkManager::FindChunk(int cx, int cz) {
+    auto it = chunks.find({ cx, cz });
+    return it != chunks.end() ? it->second : nullptr;
+}
+
+const Chunk* ChunkManager::FindChunk(int cx, int cz) const {
+    auto it = chunks.find({ cx, cz });
+    return it != chunks.end() ? it->second : nullptr;
+}
+
+Chunk& ChunkManager::GetOrCreateChunk(int cx, int cz) {
+    ChunkCoord coord = { cx, cz };
+    auto it = chunks.find(coord);
+    if (it != chunks.end()) return *it->second;
+    Chunk* thawed = ThawChunk(coord);
+    if (thawed) return *thawed;
+
+    Chunk& chunk = *pool.Acquire();
+    chunks[coord] = &chunk;
+    chunk.requestTime = Profiler::NowMs();
+    GenerateChunk(chunk, cx, cz);
+    AttachChunk(chunk, coord);
+    return chunk;
+}
+
+void ChunkManager::GenerateBatch(const std::vector<ChunkCoord>& coords) {
+    std::vector<ChunkCoord> fresh;
+    std::vector<Chunk*> created;
+    for (const ChunkCoord& coord : coords) {
+        if (chunks.count(coord) || ThawChunk(coord)) continue;
+        Chunk* chunk = pool.Acquire();
+        chunks[coord] = chunk;
+        chunk->requestTime = Profiler::NowMs();
+        fresh.push_back(coord);
+        created.push_back(chunk);
+    }
+
+    // nothing else touches the chunks until the batch is done
+    JobSystem::ParallelFor((int)fresh.size(), [&](int i) {
+        GenerateChunk(*created[i], fresh[i].x, fresh[i].z);
+    });
+    for (size_t i = 0; i < fresh.size(); i++) AttachChunk(*created[i], fresh[i]);
+}
+
+// the 8 chunks around one, ordered so the opposite of offset i is 7 - i
+static const int NEIGHBOUR_OFFSETS[8][2] = {
+    { -1, -1 }, { -1, 0 }, { -1, 1 }, { 0, -1 }, { 0, 1 }, { 1, -1 }, { 1, 0 }, { 1, 1 }
+};
+
+/**
+ * sections along the side of a chunk that faces (dx, dz)
+ */
+static uint64_t BorderSections(int dx, int dz) {
+    uint64_t mask = 0;
+    int last = CHUNK_SIZE - SECTION_SIZE;
+    for (int a = 0; a < CHUNK_SIZE; a += SECTION_SIZE) {
+        for (int y = 0; y < CHUNK_SIZE; y += SECTION_SIZE) {
+            if (dx != 0) mask |= 1ull << SectionIndex(dx > 0 ? last : 0, y, a);
+            else mask |= 1ull << SectionIndex(a, y, dz > 0 ? last : 0);
+        }
+    }
+    return mask;
+}
 
-    // rebuild mesh
-    chunks[coord].meshReady = false;
-    chunks[coord].shouldStep = true;
-    
-    // update neighbors
-    if (lx == 0) RebuildMesh(cx - 1, cz, nullptr);
-    if (lx == CHUNK_SIZE - 1) RebuildMesh(cx + 1, cz, nullptr);
-    if (lz == 0) RebuildMesh(cx, cz - 1, nullptr);
-    if (lz == CHUNK_SIZE - 1) RebuildMesh(cx, cz + 1, nullptr);
+/**
+ * a chunk just arrived (generated and lit): records it in the neighbour
+ * masks around it and moves chunks whose last neighbour this was to READY.
+ * a meshed chunk was meshed without this one, so its border sections on
+ * that side are rebuilt once
+ */
+void ChunkManager::LinkNeighbours(Chunk& chunk, ChunkCoord coord) {
+    for (int i = 0; i < 8; i++) {
+        int dx = NEIGHBOUR_OFFSETS[i][0];
+        int dz = NEIGHBOUR_OFFSETS[i][1];
+        Chunk* other = FindChunk(coord.x + dx, coord.z + dz);
+        if (!other) continue;
+
+        chunk.neighbourMask |= 1 << i;
+        other->neighbourMask |= 1 << (7 - i);
+
+        if (other->state == ChunkState::WAITING && other->neighbourMask == ALL_NEIGHBOURS) {
+            other->state = ChunkState::READY;
+        }
+        else if (other->state == ChunkState::MESHED && (dx == 0 || dz == 0)) {
+            other->dirtySections |= BorderSections(-dx, -dz);
+            other->borderFixPending = true;
+        }
+    }
+    if (chunk.neighbourMask == ALL_NEIGHBOURS) chunk.state = ChunkState::READY;
+}
+
+size_t ChunkManager::GetChunkCount() const {
+    return chunks.size();
 }
 
 bool ChunkManager::IsBlockSolid(int x, int y, int z) {
-    return GetBlock(x, y, z) != BlockType::AIR;
+    return IsSolid(GetBlock(x, y, z));
 }
 
+/**
+ * everything about a new chunk that only needs the chunk itself (safe to
+ * run on a worker, one chunk per job)
+ */
 void ChunkManager::GenerateChunk(Chunk& chunk, int chunkX, int chunkZ) {
+    PROFILE_SCOPE(ProfileZone::GENERATION);
+
     WorldGenerator::GenerateChunk(chunk, chunkX, chunkZ);
     ComputeChunkLighting(chunk);
+    RebuildOccupancy(chunk);
+}
 
-    // wake up the chunk so floating sand can settle
-    chunk.shouldStep = true;
+/**
+ * the rest, on the main thread: physics and fluid queues (which look
+ * across the border) and the neighbour links
+ */
+void ChunkManager::AttachChunk(Chunk& chunk, ChunkCoord coord) {
+    // only sand generated over caves needs to settle, and only water
+    // next to air (caves, this chunk's edges) can flow
+    SeedActiveCells(chunk, coord);
+    SeedFluids(chunk, coord);
+    LinkNeighbours(chunk, coord);
 }
 
-void ChunkManager::ComputeChunkLighting(Chunk& chunk) {
-    // CLEAR LIGHTING (Reset to 0)
+/**
+ * derives the section counts and occupancy columns from the blocks
+ */
+void ChunkManager::RebuildOccupancy(Chunk& chunk) {
+    memset(chunk.sectionCounts, 0, sizeof(chunk.sectionCounts));
     for (int x = 0; x < CHUNK_SIZE; x++) {
-        for (int y = 0; y < CHUNK_SIZE; y++) {
-            for (int z = 0; z < CHUNK_SIZE; z++) {
-                chunk.light[x][y][z] = 0;
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            RebuildColumn(chunk, x, z);
+            uint64_t filled = chunk.blockColumns[x][z] | chunk.waterColumns[x][z];
+            for (int y = 0; y < CHUNK_SIZE; y += SECTION_SIZE) {
+                uint64_t section = (filled >> y) & ((1ull << SECTION_SIZE) - 1);
+                chunk.sectionCounts[SectionIndex(x, y, z)] += (unsigned short)PopCount(section);
             }
         }
     }
+}
+
+/**
+ * queues the scheduled behaviours of a block and its six neighbours
+ */
+void ChunkManager::ScheduleAround(int x, int y, int z) {
+    static const int offsets[7][3] = {
+        { 0, 0, 0 }, { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }
+    };
+    BlockAccessor blocks(*this);
+    for (int i = 0; i < 7; i++) {
+        int nx = x + offsets[i][0];
+        int ny = y + offsets[i][1];
+        int nz = z + offsets[i][2];
+        ticks.Schedule(blocks.Get(nx, ny, nz), nx, ny, nz);
+    }
+}
+
+void ChunkManager::ActivateCell(Chunk& chunk, ChunkCoord coord, int x, int y, int z) {
+    if (chunk.activeCells.empty()) activeChunks.insert(coord);
+    chunk.activeCells.push_back(PackCell(x, y, z));
+}
+
+/**
+ * queues every sand block that has air or water under it
+ */
+void ChunkManager::SeedActiveCells(Chunk& chunk, ChunkCoord coord) {
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            for (int y = 1; y <= chunk.heightMap[x][z]; y++) {
+                if (chunk.blocks[x][y][z] == BlockType::SAND && !IsSolid(chunk.blocks[x][y - 1][z])) {
+                    ActivateCell(chunk, coord, x, y, z);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * recomputes heightmap and biome map for a chunk whose blocks came from disk
+ */
+void ChunkManager::RebuildColumnData(Chunk& chunk, int chunkX, int chunkZ) {
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            int top = CHUNK_SIZE - 1;
+            while (top > 0 && chunk.blocks[x][top][z] == BlockType::AIR) top--;
+            chunk.heightMap[x][z] = (unsigned char)top;
+
+            int sun = top + 1;
+            while (sun > 0 && !BlocksSunlight(chunk.blocks[x][sun - 1][z])) sun--;
+            chunk.sunHeight[x][z] = (unsigned char)sun;
+            chunk.biomeMap[x][z] = WorldGenerator::GetBiome(chunkX * CHUNK_SIZE + x, chunkZ * CHUNK_SIZE + z);
+        }
+    }
+}
+
+void ChunkManager::ComputeChunkLighting(Chunk& chunk) {
+    PROFILE_SCOPE(ProfileZone::LIGHTING);
+
+    // CLEAR LIGHTING (Reset to 0)
+    memset(chunk.light, 0, sizeof(chunk.light));
 
     std::queue<LightNode> sunQueue;
     std::queue<LightNode> torchQueue;
@@ -112,27 +521,31 @@ void ChunkManager::ComputeChunkLighting(Chunk& chunk) {
     for (int x = 0; x < CHUNK_SIZE; x++) {
         for (int z = 0; z < CHUNK_SIZE; z++) {
 
-            // SUNLIGHT (Column Scan)
-            bool sunBlocked = false;
-            for (int y = CHUNK_SIZE - 1; y >= 0; y--) {
-                BlockType block = chunk.blocks[x][y][z];
-                // Light passes through Air, Leaves, and Torches
-                bool solid = (block != BlockType::AIR && block != BlockType::LEAVES && block != BlockType::SNOW_LEAVES && block != BlockType::TORCH && block != BlockType::GLOWSTONE);
+            // SUNLIGHT (Heightmap)
+            // everything from sunHeight up is lit directly. only cells next to a
+            // column that is shaded at that height can spread anything, so those
+            // are the only ones that need to go into the bfs
+            int sunY = chunk.sunHeight[x][z];
+            int shadeTop = sunY;
+            if (x > 0) shadeTop = std::max(shadeTop, (int)chunk.sunHeight[x - 1][z]);
+            if (x < CHUNK_SIZE - 1) shadeTop = std::max(shadeTop, (int)chunk.sunHeight[x + 1][z]);
+            if (z > 0) shadeTop = std::max(shadeTop, (int)chunk.sunHeight[x][z - 1]);
+            if (z < CHUNK_SIZE - 1) shadeTop = std::max(shadeTop, (int)chunk.sunHeight[x][z + 1]);
+
+            for (int y = sunY; y < CHUNK_SIZE; y++) {
+                // Set Sun Bit (High Nibble) to 15 -> (15 << 4) = 240
+                chunk.light[x][y][z] |= (15 << 4);
+                if (y < shadeTop) sunQueue.push({ x, y, z, 15 });
+            }
 
-                if (!sunBlocked) {
-                    if (solid) {
-                        sunBlocked = true;
-                    }
-                    else {
-                        // Set Sun Bit (High Nibble) to 15 -> (15 << 4) = 240
-                        chunk.light[x][y][z] |= (15 << 4);
-                        sunQueue.push({ x, y, z, 15 });
-                    }
-                }
+            // the sun stops at the water surface and fades from there, one level per block
+            if (sunY > 0 && chunk.blocks[x][sunY - 1][z] == BlockType::WATER) {
+                chunk.light[x][sunY - 1][z] |= (14 << 4);
+                sunQueue.push({ x, sunY - 1, z, 14 });
             }
 
-            // TORCHLIGHT (Scan for emitters)
-            for (int y = 0; y < CHUNK_SIZE; y++) {
+            // TORCHLIGHT (Scan for emitters, nothing lives above the heightmap)
+            for (int y = 0; y <= chunk.heightMap[x][z]; y++) {
                 BlockType block = chunk.blocks[x][y][z];
                 if (block == BlockType::TORCH || block == BlockType::GLOWSTONE) {
                     // Set Torch Bit (Low Nibble) to 14 (Torches aren't fully 15 bright usually)
@@ -156,10 +569,7 @@ void ChunkManager::ComputeChunkLighting(Chunk& chunk) {
             int nz = node.z + neighbors[i][2];
 
             if (nx >= 0 && nx < CHUNK_SIZE && ny >= 0 && ny < CHUNK_SIZE && nz >= 0 && nz < CHUNK_SIZE) {
-                BlockType block = chunk.blocks[nx][ny][nz];
-                bool solid = (block != BlockType::AIR && block != BlockType::LEAVES && block != BlockType::SNOW_LEAVES && block != BlockType::TORCH && block != BlockType::GLOWSTONE);
-
-                if (!solid) {
+                if (!IsOpaque(chunk.blocks[nx][ny][nz])) {
                     int currentSun = (chunk.light[nx][ny][nz] >> 4) & 0xF;
                     if (currentSun < node.val - 1) {
                         int newSun = node.val - 1;
@@ -186,10 +596,7 @@ void ChunkManager::ComputeChunkLighting(Chunk& chunk) {
             int nz = node.z + neighbors[i][2];
 
             if (nx >= 0 && nx < CHUNK_SIZE && ny >= 0 && ny < CHUNK_SIZE && nz >= 0 && nz < CHUNK_SIZE) {
-                BlockType block = chunk.blocks[nx][ny][nz];
-                bool solid = (block != BlockType::AIR && block != BlockType::LEAVES && block != BlockType::SNOW_LEAVES && block != BlockType::TORCH && block != BlockType::GLOWSTONE);
-
-                if (!solid) {
+                if (!IsOpaque(chunk.blocks[nx][ny][nz])) {
                     int currentTorch = chunk.light[nx][ny][nz] & 0xF;
                     if (currentTorch < node.val - 1) {
                         int newTorch = node.val - 1;
@@ -204,37 +611,182 @@ void ChunkManager::ComputeChunkLighting(Chunk& chunk) {
     }
 }
 
-// Memory Pool
-static std::vector<float> poolVertices[(int)BlockType::COUNT];
-static std::vector<float> poolTexcoords[(int)BlockType::COUNT];
-static std::vector<unsigned char> poolColors[(int)BlockType::COUNT];
+void MeshBuffers::Clear() {
+    for (int i = 0; i < (int)BlockType::COUNT; i++) {
+        vertices[i].clear();
+        texcoords[i].clear();
+        colors[i].clear();
+    }
+}
+
+size_t MeshBuffers::VertexCount() const {
+    size_t count = 0;
+    for (int i = 0; i < (int)BlockType::COUNT; i++) count += vertices[i].size() / 3;
+    return count;
+}
+
+size_t MeshBuffers::CapacityBytes() const {
+    size_t bytes = 0;
+    for (int i = 0; i < (int)BlockType::COUNT; i++) {
+        bytes += (vertices[i].capacity() + texcoords[i].capacity()) * sizeof(float) + colors[i].capacity();
+    }
+    return bytes;
+}
+
+Model UploadLayer(std::vector<float>& vertices, std::vector<float>& texcoords, std::vector<unsigned char>& colors) {
+    Mesh mesh = { 0 };
+    mesh.vertexCount = (int)vertices.size() / 3;
+    mesh.triangleCount = mesh.vertexCount / 3;
+    mesh.vertices = vertices.data();
+    mesh.texcoords = texcoords.data();
+    mesh.colors = colors.data();
+    UploadMesh(&mesh, false);
+    mesh.vertices = nullptr;
+    mesh.texcoords = nullptr;
+    mesh.colors = nullptr;
+    return LoadModelFromMesh(mesh);
+}
+
+// Memory Pool: the dirty sections' new vertices and their faces
+static MeshBuffers meshPool;
+static std::vector<uint64_t> faceScratch;
+
+// stream entries per face (two triangles)
+static const size_t FACE_VERTEX_FLOATS = 18;
+static const size_t FACE_TEXCOORD_FLOATS = 12;
+static const size_t FACE_COLOR_BYTES = 24;
+
+// face directions, in the order the mesher tests them
+enum FaceDir { FACE_FRONT, FACE_BACK, FACE_TOP, FACE_BOTTOM, FACE_RIGHT, FACE_LEFT };
+
+static_assert(CHUNK_SIZE <= 64, "face cells are packed in 6 bits per axis");
+static_assert((int)BlockType::COUNT <= 32, "face layers are packed in 5 bits");
 
 /**
- * generates mesh data for a chunk using neighbor caching and memory pooling
+ * one visible face: local cell (6 bits per axis), direction, render layer,
+ * packed light of the cell it faces, and its top edge in ninths of a block
+ * (lower than 9 only for open water surfaces)
  */
-void ChunkManager::BuildChunkMesh(Chunk& chunk, int cx, int cz, Texture2D* textures) {
-    UnloadChunkModels(chunk);
+static inline uint64_t PackFace(int x, int y, int z, int dir, int layer, int light, int top) {
+    return (uint64_t)x | (uint64_t)y << 6 | (uint64_t)z << 12 | (uint64_t)dir << 18 |
+        (uint64_t)layer << 21 | (uint64_t)light << 26 | (uint64_t)top << 34;
+}
 
-    // 1. neighbor caching
-    Chunk* neighbors[3][3];
-    for (int nx = -1; nx <= 1; nx++) {
-        for (int nz = -1; nz <= 1; nz++) {
-            ChunkCoord coord = { cx + nx, cz + nz };
-            auto it = chunks.find(coord);
-            if (it != chunks.end()) {
-                neighbors[nx + 1][nz + 1] = &it->second;
-            } else {
-                neighbors[nx + 1][nz + 1] = nullptr;
-            }
-        }
+/**
+ * turns a packed face into two triangles in the layer's vertex streams
+ */
+static inline int FaceLayer(uint64_t face) {
+    return (int)(face >> 21) & 31;
+}
+
+static void EmitFace(uint64_t face, float originX, float originZ, MeshBuffers& out) {
+    int layer = FaceLayer(face);
+    int light = (int)(face >> 26) & 255;
+    float gx = originX + (float)(face & 63);
+    float gy = (float)((face >> 6) & 63);
+    float gz = originZ + (float)((face >> 12) & 63);
+    float gt = gy + (float)((face >> 34) & 15) / (WATER_SOURCE_LEVEL + 1);
+
+    static const float uvSide[] = { 0, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0 };
+    static const float uvBottom[] = { 0, 1, 1, 1, 0, 0, 0, 0, 1, 1, 1, 0 };
+    const float* uv = uvSide;
+
+    float v[18];
+    switch ((FaceDir)((face >> 18) & 7)) {
+    case FACE_FRONT: {
+        float f[] = { gx, gy, gz + 1, gx + 1, gy, gz + 1, gx + 1, gt, gz + 1, gx, gy, gz + 1, gx + 1, gt, gz + 1, gx, gt, gz + 1 };
+        memcpy(v, f, sizeof(v));
+        break;
+    }
+    case FACE_BACK: {
+        float f[] = { gx + 1, gy, gz, gx, gy, gz, gx, gt, gz, gx + 1, gy, gz, gx, gt, gz, gx + 1, gt, gz };
+        memcpy(v, f, sizeof(v));
+        break;
+    }
+    case FACE_TOP: {
+        float f[] = { gx, gt, gz + 1, gx + 1, gt, gz + 1, gx + 1, gt, gz, gx, gt, gz + 1, gx + 1, gt, gz, gx, gt, gz };
+        memcpy(v, f, sizeof(v));
+        break;
+    }
+    case FACE_BOTTOM: {
+        float f[] = { gx, gy, gz, gx + 1, gy, gz, gx, gy, gz + 1, gx, gy, gz + 1, gx + 1, gy, gz, gx + 1, gy, gz + 1 };
+        memcpy(v, f, sizeof(v));
+        uv = uvBottom;
+        break;
+    }
+    case FACE_RIGHT: {
+        float f[] = { gx + 1, gy, gz + 1, gx + 1, gy, gz, gx + 1, gt, gz, gx + 1, gy, gz + 1, gx + 1, gt, gz, gx + 1, gt, gz + 1 };
+        memcpy(v, f, sizeof(v));
+        break;
+    }
+    default: {
+        float f[] = { gx, gy, gz, gx, gy, gz + 1, gx, gt, gz + 1, gx, gy, gz, gx, gt, gz + 1, gx, gt, gz };
+        memcpy(v, f, sizeof(v));
+        break;
+    }
     }
 
-    // 2. clear pools
-    for (int i = 0; i < (int)BlockType::COUNT; i++) {
-        poolVertices[i].clear();
-        poolTexcoords[i].clear();
-        poolColors[i].clear();
+    // decode light: sun in red, torch in green
+    int sun = (light >> 4) & 0xF;
+    int torch = light & 0xF;
+    unsigned char color[4] = {
+        (unsigned char)(int)((float)sun / 15.0f * 255.0f),
+        (unsigned char)(int)((float)torch / 15.0f * 255.0f),
+        0, 255
+    };
+
+    out.vertices[layer].insert(out.vertices[layer].end(), v, v + FACE_VERTEX_FLOATS);
+    out.texcoords[layer].insert(out.texcoords[layer].end(), uv, uv + FACE_TEXCOORD_FLOATS);
+    for (int k = 0; k < 6; k++) out.colors[layer].insert(out.colors[layer].end(), color, color + 4);
+}
+
+/**
+ * appends `count` faces of one layer starting at face `first`
+ */
+static void AppendFaces(const MeshBuffers& from, int layer, size_t first, size_t count, MeshBuffers& to) {
+    const std::vector<float>& vertices = from.vertices[layer];
+    const std::vector<float>& texcoords = from.texcoords[layer];
+    const std::vector<unsigned char>& colors = from.colors[layer];
+    to.vertices[layer].insert(to.vertices[layer].end(),
+        vertices.begin() + first * FACE_VERTEX_FLOATS, vertices.begin() + (first + count) * FACE_VERTEX_FLOATS);
+    to.texcoords[layer].insert(to.texcoords[layer].end(),
+        texcoords.begin() + first * FACE_TEXCOORD_FLOATS, texcoords.begin() + (first + count) * FACE_TEXCOORD_FLOATS);
+    to.colors[layer].insert(to.colors[layer].end(),
+        colors.begin() + first * FACE_COLOR_BYTES, colors.begin() + (first + count) * FACE_COLOR_BYTES);
+}
+
+/**
+ * texture layer for one side of a block (grass and snow have their own tops and sides)
+ */
+static int GetRenderLayer(BlockType blockID, bool isTop, bool isBottom) {
+    if (blockID == BlockType::GRASS) {
+        if (isTop) return (int)BlockType::GRASS;
+        if (isBottom) return (int)BlockType::DIRT;
+        return (int)BlockType::GRASS_SIDE;
+    }
+    if (blockID == BlockType::SNOW) {
+        if (isTop) return (int)BlockType::SNOW;
+        if (isBottom) return (int)BlockType::DIRT;
+        return (int)BlockType::SNOW_SIDE;
     }
+    if (blockID == BlockType::SNOW_LEAVES) {
+        if (isTop) return (int)BlockType::SNOW;
+        if (isBottom) return (int)BlockType::LEAVES;
+        return (int)BlockType::SNOW_LEAVES;
+    }
+    return (int)blockID;
+}
+
+/**
+ * face culling for one 16^3 section, reading across chunk borders through
+ * the neighbour cache. replaces `out` with the section's visible faces.
+ * culling works on whole occupancy columns: a face shows where the cell is
+ * set and the cell next to it is not, so one shift and AND per direction
+ * finds every visible face of a column and only those cells are visited
+ */
+static void MeshSection(const Chunk& chunk, const Chunk* const neighbors[3][3], int section, std::vector<uint64_t>& out) {
+    out.clear();
+    if (chunk.sectionCounts[section] == 0) return;
 
     auto getLightFast = [&](int localX, int localY, int localZ) -> int {
         // handle y out of bounds
@@ -253,239 +805,1201 @@ void ChunkManager::BuildChunkMesh(Chunk& chunk, int cx, int cz, Texture2D* textu
         if (localZ < 0) { nz = 0; lz += CHUNK_SIZE; }
         else if (localZ >= CHUNK_SIZE) { nz = 2; lz -= CHUNK_SIZE; }
 
-        Chunk* c = neighbors[nx][nz];
+        const Chunk* c = neighbors[nx][nz];
         if (c) return (int)c->light[lx][localY][lz];
         return 0;
     };
 
-    auto getBlockFast = [&](int localX, int localY, int localZ) -> BlockType {
-        if (localY < 0 || localY >= CHUNK_SIZE) return BlockType::AIR;
-        
+    // occupancy of a horizontal neighbour column, missing chunks are empty
+    auto getColumns = [&](int localX, int localZ, uint64_t& blockBits, uint64_t& waterBits) {
         int nx = 1;
         int nz = 1;
-        int lx = localX;
-        int lz = localZ;
-
-        if (localX < 0) { nx = 0; lx += CHUNK_SIZE; }
-        else if (localX >= CHUNK_SIZE) { nx = 2; lx -= CHUNK_SIZE; }
-
-        if (localZ < 0) { nz = 0; lz += CHUNK_SIZE; }
-        else if (localZ >= CHUNK_SIZE) { nz = 2; lz -= CHUNK_SIZE; }
-        
-        Chunk* c = neighbors[nx][nz];
-        if (c) return c->blocks[lx][localY][lz];
-        return BlockType::AIR;
+        if (localX < 0) { nx = 0; localX += CHUNK_SIZE; }
+        else if (localX >= CHUNK_SIZE) { nx = 2; localX -= CHUNK_SIZE; }
+        if (localZ < 0) { nz = 0; localZ += CHUNK_SIZE; }
+        else if (localZ >= CHUNK_SIZE) { nz = 2; localZ -= CHUNK_SIZE; }
+
+        const Chunk* c = neighbors[nx][nz];
+        blockBits = c ? c->blockColumns[localX][localZ] : 0;
+        waterBits = c ? c->waterColumns[localX][localZ] : 0;
     };
 
-    for (int x = 0; x < CHUNK_SIZE; x++) {
-        for (int y = 0; y < CHUNK_SIZE; y++) {
-            for (int z = 0; z < CHUNK_SIZE; z++) {
+    int startX = (section / (SECTIONS_PER_AXIS * SECTIONS_PER_AXIS)) * SECTION_SIZE;
+    int startY = (section / SECTIONS_PER_AXIS % SECTIONS_PER_AXIS) * SECTION_SIZE;
+    int startZ = (section % SECTIONS_PER_AXIS) * SECTION_SIZE;
+    uint64_t sectionBits = ((1ull << SECTION_SIZE) - 1) << startY;
+    const int fullTop = WATER_SOURCE_LEVEL + 1;
+
+    for (int x = startX; x < startX + SECTION_SIZE; x++) {
+        for (int z = startZ; z < startZ + SECTION_SIZE; z++) {
+            uint64_t blockCol = chunk.blockColumns[x][z];
+            uint64_t waterCol = chunk.waterColumns[x][z];
+            uint64_t blocks = blockCol & sectionBits;
+            uint64_t water = waterCol & sectionBits;
+            if (!(blocks | water)) continue;
+
+            // blocks show through water, water only shows against air
+            auto visible = [&](uint64_t nextBlocks, uint64_t nextWater) {
+                return (blocks & ~nextBlocks) | (water & ~(nextBlocks | nextWater));
+            };
+
+            uint64_t nb, nw;
+            uint64_t top = visible(blockCol >> 1, waterCol >> 1);
+            uint64_t bottom = visible(blockCol << 1, waterCol << 1) & ~1ull;
+            getColumns(x - 1, z, nb, nw);
+            uint64_t left = visible(nb, nw);
+            getColumns(x + 1, z, nb, nw);
+            uint64_t right = visible(nb, nw);
+            getColumns(x, z + 1, nb, nw);
+            uint64_t front = visible(nb, nw);
+            getColumns(x, z - 1, nb, nw);
+            uint64_t back = visible(nb, nw);
+
+            // water with no water right above it is an open surface
+            uint64_t surface = water & ~(waterCol >> 1);
+
+            for (uint64_t cells = top | bottom | left | right | front | back; cells; cells &= cells - 1) {
+                int y = LowestBit(cells);
+                uint64_t bit = 1ull << y;
                 BlockType blockID = chunk.blocks[x][y][z];
-                if (blockID == BlockType::AIR) continue;
-
-                // culling checks
-                bool top = (y == CHUNK_SIZE - 1) || (getBlockFast(x, y + 1, z) == BlockType::AIR);
-                bool bottom = (y > 0) && (getBlockFast(x, y - 1, z) == BlockType::AIR);
-                bool left = (getBlockFast(x - 1, y, z) == BlockType::AIR);
-                bool right = (getBlockFast(x + 1, y, z) == BlockType::AIR);
-                bool front = (getBlockFast(x, y, z + 1) == BlockType::AIR);
-                bool back = (getBlockFast(x, y, z - 1) == BlockType::AIR);
-
-                if (!top && !bottom && !left && !right && !front && !back) continue;
 
-                float gx = (float)(cx * CHUNK_SIZE + x);
-                float gy = (float)y;
-                float gz = (float)(cz * CHUNK_SIZE + z);
-
-                auto pushFace = [&](int renderID, float* vData, float* uvData, int lightLevel) {
+                // open water surfaces sit lower the shallower the water is
+                int height = fullTop;
+                if (surface & bit) {
+                    auto level = chunk.fluidLevels.find(PackCell(x, y, z));
+                    height = level != chunk.fluidLevels.end() ? level->second : WATER_SOURCE_LEVEL;
+                }
 
-                    // decode light
-                    int sun = (lightLevel >> 4) & 0xF;
-                    int torch = lightLevel & 0xF;
+                int side = GetRenderLayer(blockID, false, false);
+                if (front & bit)  out.push_back(PackFace(x, y, z, FACE_FRONT, side, getLightFast(x, y, z + 1), height));
+                if (back & bit)   out.push_back(PackFace(x, y, z, FACE_BACK, side, getLightFast(x, y, z - 1), height));
+                if (top & bit)    out.push_back(PackFace(x, y, z, FACE_TOP, GetRenderLayer(blockID, true, false), getLightFast(x, y + 1, z), height));
+                if (bottom & bit) out.push_back(PackFace(x, y, z, FACE_BOTTOM, GetRenderLayer(blockID, false, true), getLightFast(x, y - 1, z), height));
+                if (right & bit)  out.push_back(PackFace(x, y, z, FACE_RIGHT, side, getLightFast(x + 1, y, z), height));
+                if (left & bit)   out.push_back(PackFace(x, y, z, FACE_LEFT, side, getLightFast(x - 1, y, z), height));
+            }
+        }
+    }
+}
 
-                    // convert to byte
-                    int r = (int)((float)sun / 15.0f * 255.0f);
-                    int g = (int)((float)torch / 15.0f * 255.0f);
+void ChunkManager::GetMeshNeighbours(int cx, int cz, const Chunk* neighbours[3][3]) const {
+    for (int nx = -1; nx <= 1; nx++) {
+        for (int nz = -1; nz <= 1; nz++) {
+            neighbours[nx + 1][nz + 1] = FindChunk(cx + nx, cz + nz);
+        }
+    }
+}
 
-                    Color c = { (unsigned char)r, (unsigned char)g, 0, 255 };
+/**
+ * re-scans and re-emits only the dirty sections, splices their vertices into
+ * the chunk's layer streams and re-uploads the layers that changed (one model
+ * per layer keeps draw calls per chunk low)
+ */
+void ChunkManager::BuildChunkMesh(Chunk& chunk, int cx, int cz, Texture2D* textures) {
+    PROFILE_SCOPE(ProfileZone::MESHING);
+
+    ThawAround(cx, cz);
+    const Chunk* neighbors[3][3];
+    GetMeshNeighbours(cx, cz, neighbors);
+
+    // new vertices of the dirty sections, in section order within each layer
+    meshPool.Clear();
+    float originX = (float)(cx * CHUNK_SIZE);
+    float originZ = (float)(cz * CHUNK_SIZE);
+    unsigned short fresh[SECTIONS_PER_CHUNK][(int)BlockType::COUNT];
+    uint32_t changedLayers = 0;
+    for (int section = 0; section < SECTIONS_PER_CHUNK; section++) {
+        if (!(chunk.dirtySections & (1ull << section))) continue;
+        MeshSection(chunk, neighbors, section, faceScratch);
+        memset(fresh[section], 0, sizeof(fresh[section]));
+        for (uint64_t face : faceScratch) {
+            EmitFace(face, originX, originZ, meshPool);
+            fresh[section][FaceLayer(face)]++;
+        }
+        for (int i = 0; i < (int)BlockType::COUNT; i++) {
+            if (fresh[section][i] || chunk.sectionFaces[section][i]) changedLayers |= 1u << i;
+        }
+    }
 
-                    for (int k = 0; k < 18; k++) poolVertices[renderID].push_back(vData[k]);
-                    for (int k = 0; k < 12; k++) poolTexcoords[renderID].push_back(uvData[k]);
-                    for (int k = 0; k < 6; k++) {
-                        poolColors[renderID].push_back(c.r);
-                        poolColors[renderID].push_back(c.g);
-                        poolColors[renderID].push_back(c.b);
-                        poolColors[renderID].push_back(c.a);
-                    }
-                };
+    // clean sections keep their old vertices, dirty ones take the new ones.
+    // the streams are sized exactly, every meshed chunk keeps them
+    MeshBuffers spliced;
+    for (int i = 0; i < (int)BlockType::COUNT; i++) {
+        if (!(changedLayers & (1u << i))) continue;
 
-                auto getRenderID = [&](bool isTop, bool isBottom) -> int {
-                    if (blockID == BlockType::GRASS) {
-                        if (isTop) return (int)BlockType::GRASS;
-                        if (isBottom) return (int)BlockType::DIRT;
-                        return (int)BlockType::GRASS_SIDE;
-                    }
-                    if (blockID == BlockType::SNOW) {
-                        if (isTop) return (int)BlockType::SNOW;
-                        if (isBottom) return (int)BlockType::DIRT;
-                        return (int)BlockType::SNOW_SIDE;
-                    }
-                    if (blockID == BlockType::SNOW_LEAVES) {
-                        if (isTop) return (int)BlockType::SNOW;
-                        if (isBottom) return (int)BlockType::LEAVES;
-                        return (int)BlockType::SNOW_LEAVES;
-                    }
-                    return (int)blockID;
-                };
-
-                float fFront[] = { gx, gy, gz + 1, gx + 1, gy, gz + 1, gx + 1, gy + 1, gz + 1, gx, gy, gz + 1, gx + 1, gy + 1, gz + 1, gx, gy + 1, gz + 1 };
-                float uvFront[] = { 0, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0 };
-                float fBack[] = { gx + 1, gy, gz, gx, gy, gz, gx, gy + 1, gz, gx + 1, gy, gz, gx, gy + 1, gz, gx + 1, gy + 1, gz };
-                float uvBack[] = { 0, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0 };
-                float fTop[] = { gx, gy + 1, gz + 1, gx + 1, gy + 1, gz + 1, gx + 1, gy + 1, gz, gx, gy + 1, gz + 1, gx + 1, gy + 1, gz, gx, gy + 1, gz };
-                float uvTop[] = { 0, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0 };
-                float fBottom[] = { gx, gy, gz, gx + 1, gy, gz, gx, gy, gz + 1, gx, gy, gz + 1, gx + 1, gy, gz, gx + 1, gy, gz + 1 };
-                float uvBottom[] = { 0, 1, 1, 1, 0, 0, 0, 0, 1, 1, 1, 0 }; 
-                float fRight[] = { gx + 1, gy, gz + 1, gx + 1, gy, gz, gx + 1, gy + 1, gz, gx + 1, gy, gz + 1, gx + 1, gy + 1, gz, gx + 1, gy + 1, gz + 1 };
-                float uvRight[] = { 0, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0 };
-                float fLeft[] = { gx, gy, gz, gx, gy, gz + 1, gx, gy + 1, gz + 1, gx, gy, gz, gx, gy + 1, gz + 1, gx, gy + 1, gz };
-                float uvLeft[] = { 0, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0 };
-
-                if (front)  pushFace(getRenderID(false, false), fFront, uvFront, getLightFast(x, y, z + 1));
-                if (back)   pushFace(getRenderID(false, false), fBack, uvBack, getLightFast(x, y, z - 1));
-                if (top)    pushFace(getRenderID(true, false), fTop, uvTop, getLightFast(x, y + 1, z));
-                if (bottom) pushFace(getRenderID(false, true), fBottom, uvBottom, getLightFast(x, y - 1, z));
-                if (right)  pushFace(getRenderID(false, false), fRight, uvRight, getLightFast(x + 1, y, z));
-                if (left)   pushFace(getRenderID(false, false), fLeft, uvLeft, getLightFast(x - 1, y, z));
+        size_t faces = 0;
+        for (int section = 0; section < SECTIONS_PER_CHUNK; section++) {
+            faces += (chunk.dirtySections & (1ull << section)) ? fresh[section][i] : chunk.sectionFaces[section][i];
+        }
+        spliced.vertices[i].reserve(faces * FACE_VERTEX_FLOATS);
+        spliced.texcoords[i].reserve(faces * FACE_TEXCOORD_FLOATS);
+        spliced.colors[i].reserve(faces * FACE_COLOR_BYTES);
+
+        size_t oldFirst = 0;
+        size_t freshFirst = 0;
+        for (int section = 0; section < SECTIONS_PER_CHUNK; section++) {
+            size_t oldCount = chunk.sectionFaces[section][i];
+            if (chunk.dirtySections & (1ull << section)) {
+                AppendFaces(meshPool, i, freshFirst, fresh[section][i], spliced);
+                freshFirst += fresh[section][i];
+                chunk.sectionFaces[section][i] = fresh[section][i];
             }
+            else {
+                AppendFaces(chunk.meshData, i, oldFirst, oldCount, spliced);
+            }
+            oldFirst += oldCount;
         }
+
+        chunk.meshData.vertices[i] = std::move(spliced.vertices[i]);
+        chunk.meshData.texcoords[i] = std::move(spliced.texcoords[i]);
+        chunk.meshData.colors[i] = std::move(spliced.colors[i]);
     }
+    // what the build was for (an edit waiting at the same time rides along with a fix-up)
+    if (chunk.state != ChunkState::MESHED) stats.firstMeshes++;
+    else if (chunk.borderFixPending) stats.borderFixups++;
+    else stats.meshRebuilds++;
+    chunk.borderFixPending = false;
+    chunk.dirtySections = 0;
+    chunk.state = ChunkState::MESHED;
+
+    // no gl context (headless runs): keep the cpu work, skip the upload
+    if (!IsWindowReady()) return;
+
+    chunk.gpuBytes = chunk.meshData.VertexCount() * UPLOAD_VERTEX_BYTES;
 
     for (int i = 1; i < (int)BlockType::COUNT; i++) {
-        if (poolVertices[i].empty()) continue;
-        Mesh mesh = { 0 };
-        mesh.vertexCount = (int)poolVertices[i].size() / 3;
-        mesh.triangleCount = mesh.vertexCount / 3;
-        mesh.vertices = (float*)MemAlloc((unsigned int)(poolVertices[i].size() * sizeof(float)));
-        mesh.texcoords = (float*)MemAlloc((unsigned int)(poolTexcoords[i].size() * sizeof(float)));
-        mesh.colors = (unsigned char*)MemAlloc((unsigned int)(poolColors[i].size() * sizeof(unsigned char)));
-        memcpy(mesh.vertices, poolVertices[i].data(), poolVertices[i].size() * sizeof(float));
-        memcpy(mesh.texcoords, poolTexcoords[i].data(), poolTexcoords[i].size() * sizeof(float));
-        memcpy(mesh.colors, poolColors[i].data(), poolColors[i].size() * sizeof(unsigned char));
-        UploadMesh(&mesh, false);
-        chunk.layers[i] = LoadModelFromMesh(mesh);
-        
+        if (!(changedLayers & (1u << i))) continue;
+        if (chunk.layers[i].meshCount > 0) {
+            UnloadModel(chunk.layers[i]);
+            chunk.layers[i] = { 0 };
+        }
+
+        if (chunk.meshData.vertices[i].empty()) continue;
+        chunk.layers[i] = UploadLayer(chunk.meshData.vertices[i], chunk.meshData.texcoords[i], chunk.meshData.colors[i]);
+
         // safety check for nullptr textures if not loaded yet
         if (textures) {
             chunk.layers[i].materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = textures[i];
         }
     }
-    chunk.meshReady = true;
 }
 
-void ChunkManager::UpdateAndDraw(Vector3 playerPos, Texture2D* textures, Shader shader, Color tint) {
+void ChunkManager::BuildMeshData(int cx, int cz, MeshBuffers& out) {
+    ThawAround(cx, cz);
+    Chunk* chunk = FindChunk(cx, cz);
+    if (chunk) BuildMeshData(*chunk, cx, cz, out);
+    else out.Clear();
+}
+
+/**
+ * cpu half of meshing for the whole chunk: every section, no gpu calls
+ * and nothing cached on the chunk
+ */
+void ChunkManager::BuildMeshData(const Chunk& chunk, int cx, int cz, MeshBuffers& out) const {
+    const Chunk* neighbors[3][3];
+    GetMeshNeighbours(cx, cz, neighbors);
+
+    out.Clear();
+    std::vector<uint64_t> faces;
+    float originX = (float)(cx * CHUNK_SIZE);
+    float originZ = (float)(cz * CHUNK_SIZE);
+    for (int section = 0; section < SECTIONS_PER_CHUNK; section++) {
+        MeshSection(chunk, neighbors, section, faces);
+        for (uint64_t face : faces) EmitFace(face, originX, originZ, out);
+    }
+}
+
+void ChunkManager::RankOffsets(int radius, Vector3 viewDir, std::vector<ChunkCoord>& out) {
+    float length = sqrtf(viewDir.x * viewDir.x + viewDir.z * viewDir.z);
+    float viewX = length > 0.0f ? viewDir.x / length : 0.0f;
+    float viewZ = length > 0.0f ? viewDir.z / length : 0.0f;
+
+    std::vector<std::pair<float, ChunkCoord>> ranked;
+    for (int dx = -radius; dx <= radius; dx++) {
+        for (int dz = -radius; dz <= radius; dz++) {
+            float distance = sqrtf((float)(dx * dx + dz * dz));
+            float rank = distance;
+            if (distance > 1.5f) rank *= 1.5f - 0.5f * (dx * viewX + dz * viewZ) / distance;
+            ranked.push_back({ rank, { dx, dz } });
+        }
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const std::pair<float, ChunkCoord>& a, const std::pair<float, ChunkCoord>& b) {
+        if (a.first != b.first) return a.first < b.first;
+        return a.second < b.second;
+    });
+
+    out.clear();
+    for (const auto& entry : ranked) out.push_back(entry.second);
+}
+
+/**
+ * the streaming half of a frame: re-ranks the order if needed, generates up
+ * to GENERATE_BUDGET chunks within one ring past RENDER_DISTANCE, then
+ * meshes up to MESH_BUDGET new chunks and every stale meshed one
+ */
+void ChunkManager::StreamChunks(Vector3 playerPos, Vector3 viewDir, Texture2D* textures) {
     int playerCX = (int)floor(playerPos.x / CHUNK_SIZE);
     int playerCZ = (int)floor(playerPos.z / CHUNK_SIZE);
 
-    for (int cx = playerCX - RENDER_DISTANCE; cx <= playerCX + RENDER_DISTANCE; cx++) {
-        for (int cz = playerCZ - RENDER_DISTANCE; cz <= playerCZ + RENDER_DISTANCE; cz++) {
-            ChunkCoord coord = { cx, cz };
-            if (chunks.find(coord) == chunks.end()) {
-                GenerateChunk(chunks[coord], cx, cz);
-            }
-            Chunk& chunk = chunks[coord];
-            if (!chunk.meshReady) {
-                BuildChunkMesh(chunk, cx, cz, textures);
+    int sector = SCHEDULE_SECTORS;
+    if (viewDir.x != 0.0f || viewDir.z != 0.0f) {
+        float turns = atan2f(viewDir.z, viewDir.x) / (2.0f * PI) + 1.0f;
+        sector = (int)(turns * SCHEDULE_SECTORS + 0.5f) % SCHEDULE_SECTORS;
+    }
+    ChunkCoord center = { playerCX, playerCZ };
+    bool moved = scheduleRadius == RENDER_DISTANCE + 1 && (center.x != scheduleCenter.x || center.z != scheduleCenter.z);
+    ChunkCoord previous = scheduleCenter;
+    if (sector != scheduleSector || RENDER_DISTANCE + 1 != scheduleRadius || center.x != scheduleCenter.x || center.z != scheduleCenter.z) {
+        // rank against the sector's centre so the order only depends on what triggers a rebuild
+        Vector3 sectorDir = { 0, 0, 0 };
+        if (sector < SCHEDULE_SECTORS) {
+            float angle = sector * 2.0f * PI / SCHEDULE_SECTORS;
+            sectorDir = { cosf(angle), 0.0f, sinf(angle) };
+        }
+        RankOffsets(RENDER_DISTANCE + 1, sectorDir, scheduleOrder);
+        scheduleCenter = center;
+        scheduleSector = sector;
+        scheduleRadius = RENDER_DISTANCE + 1;
+    }
+
+    // chunks left behind make room for the ones coming up
+    if (moved) FreezeFarChunks(center);
+
+    int pendingGenerate = 0;
+    int generateBudget = GENERATE_BUDGET;
+    int thawBudget = THAW_BUDGET;
+    for (const ChunkCoord& offset : scheduleOrder) {
+        ChunkCoord coord = { playerCX + offset.x, playerCZ + offset.z };
+        if (chunks.count(coord)) continue;
+        if (thawBudget > 0 && ThawChunk(coord)) {
+            thawBudget--;
+            continue;
+        }
+        if (generateBudget > 0) {
+            GetOrCreateChunk(coord.x, coord.z);
+            generateBudget--;
+        }
+        else pendingGenerate++;
+    }
+
+    // budget the ranked order did not need goes to the predicted path
+    for (const PrefetchEntry& entry : prefetchQueue) {
+        if (generateBudget == 0) break;
+        if (chunks.count(entry.coord)) continue;
+        GetOrCreateChunk(entry.coord.x, entry.coord.z);
+        generateBudget--;
+        stats.prefetched++;
+    }
+
+    int meshBudget = MESH_BUDGET;
+    for (const ChunkCoord& offset : scheduleOrder) {
+        if (abs(offset.x) > RENDER_DISTANCE || abs(offset.z) > RENDER_DISTANCE) continue;
+        Chunk* chunk = FindChunk(playerCX + offset.x, playerCZ + offset.z);
+        if (!chunk || chunk->state == ChunkState::WAITING || !chunk->dirtySections) continue;
+        if (chunk->state == ChunkState::READY) {
+            if (meshBudget == 0) continue;
+            meshBudget--;
+        }
+        BuildChunkMesh(*chunk, playerCX + offset.x, playerCZ + offset.z, textures);
+    }
+
+    for (const PrefetchEntry& entry : prefetchQueue) {
+        if (meshBudget == 0) break;
+        Chunk* chunk = FindChunk(entry.coord.x, entry.coord.z);
+        if (!entry.mesh || !chunk || chunk->state != ChunkState::READY) continue;
+        BuildChunkMesh(*chunk, entry.coord.x, entry.coord.z, textures);
+        meshBudget--;
+    }
+    prefetchQueue.erase(std::remove_if(prefetchQueue.begin(), prefetchQueue.end(), [&](const PrefetchEntry& entry) {
+        const Chunk* chunk = FindChunk(entry.coord.x, entry.coord.z);
+        return chunk && (!entry.mesh || chunk->state == ChunkState::MESHED);
+    }), prefetchQueue.end());
+
+    // chunks that came into range this frame and still have nothing to draw
+    if (moved) {
+        for (const ChunkCoord& offset : scheduleOrder) {
+            if (abs(offset.x) > RENDER_DISTANCE || abs(offset.z) > RENDER_DISTANCE) continue;
+            ChunkCoord coord = { playerCX + offset.x, playerCZ + offset.z };
+            if (abs(coord.x - previous.x) <= RENDER_DISTANCE && abs(coord.z - previous.z) <= RENDER_DISTANCE) continue;
+            const Chunk* chunk = FindChunk(coord.x, coord.z);
+            if (!chunk || chunk->state != ChunkState::MESHED) stats.missedChunks++;
+        }
+    }
+
+    RefreshStats(pendingGenerate);
+}
+
+/**
+ * moves every chunk more than COLD_MARGIN past the generated ring into the
+ * cold tier, then trims the tier to the memory budget. the same ring around
+ * each chunk on the predicted path stays too, so prefetched chunks are not
+ * frozen before the player gets there
+ */
+void ChunkManager::FreezeFarChunks(ChunkCoord center) {
+    int keep = RENDER_DISTANCE + 1 + COLD_MARGIN;
+    std::vector<std::pair<ChunkCoord, Chunk*>> leaving;
+    for (const auto& pair : chunks) {
+        if (IsNearPath(pair.first, center, keep)) continue;
+        leaving.push_back(pair);
+    }
+    for (const auto& pair : leaving) FreezeChunk(pair.first, *pair.second);
+    TrimColdTier();
+}
+
+/**
+ * true within `radius` chunks (per axis) of the player's chunk or of a
+ * chunk on the predicted path
+ */
+bool ChunkManager::IsNearPath(ChunkCoord coord, ChunkCoord center, int radius) const {
+    if (abs(coord.x - center.x) <= radius && abs(coord.z - center.z) <= radius) return true;
+    for (const ChunkCoord& point : prefetchPath) {
+        if (abs(coord.x - point.x) <= radius && abs(coord.z - point.z) <= radius) return true;
+    }
+    return false;
+}
+
+/**
+ * compresses a chunk into the cold tier and hands its storage back to the
+ * pool. it leaves the simulation: its physics and water queues are dropped
+ * (thawing seeds them again) and its neighbours lose it from their masks,
+ * so one not meshed yet waits for it to come back
+ */
+void ChunkManager::FreezeChunk(ChunkCoord coord, Chunk& chunk) {
+    coldScratch.clear();
+    RleEncode((const unsigned char*)chunk.blocks, sizeof(chunk.blocks), coldScratch);
+    RleEncode(&chunk.light[0][0][0], sizeof(chunk.light), coldScratch);
+    RleEncode(&chunk.heightMap[0][0], sizeof(chunk.heightMap), coldScratch);
+    RleEncode((const unsigned char*)chunk.biomeMap, sizeof(chunk.biomeMap), coldScratch);
+    RleEncode(&chunk.sunHeight[0][0], sizeof(chunk.sunHeight), coldScratch);
+
+    ColdChunk& cold = coldChunks[coord];
+    cold.data.assign(coldScratch.begin(), coldScratch.end());
+    cold.fluidLevels.swap(chunk.fluidLevels);
+    cold.modified = chunk.modified;
+    cold.frozenAt = ++freezeCounter;
+    coldBytes += cold.data.size();
+    if (!cold.modified) coldOrder.push_back({ cold.frozenAt, coord });
+
+    for (int i = 0; i < 8; i++) {
+        Chunk* other = FindChunk(coord.x + NEIGHBOUR_OFFSETS[i][0], coord.z + NEIGHBOUR_OFFSETS[i][1]);
+        if (!other) continue;
+        other->neighbourMask &= ~(1 << (7 - i));
+        if (other->state == ChunkState::READY) other->state = ChunkState::WAITING;
+    }
+    activeChunks.erase(coord);
+    fluidChunks.erase(coord);
+    UnloadChunkModels(chunk);
+    pool.Release(&chunk);
+    chunks.erase(coord);
+}
+
+/**
+ * expands a cold chunk back into the world, nullptr if `coord` isn't cold
+ */
+Chunk* ChunkManager::ThawChunk(ChunkCoord coord) {
+    auto it = coldChunks.find(coord);
+    if (it == coldChunks.end()) return nullptr;
+
+    Chunk* chunk = pool.Acquire();
+    DecodeColdChunk(it->second, *chunk);
+    chunk->fluidLevels.swap(it->second.fluidLevels);
+    chunk->modified = it->second.modified;
+    chunk->requestTime = Profiler::NowMs();
+    coldBytes -= it->second.data.size();
+    coldChunks.erase(it);
+
+    chunks[coord] = chunk;
+    RebuildOccupancy(*chunk);
+    AttachChunk(*chunk, coord);
+    stats.thawed++;
+    return chunk;
+}
+
+/**
+ * the mesher reads the 3x3 around a chunk, anything cold there comes back first
+ */
+void ChunkManager::ThawAround(int cx, int cz) {
+    if (coldChunks.empty()) return;
+    for (int nx = -1; nx <= 1; nx++) {
+        for (int nz = -1; nz <= 1; nz++) {
+            if (!FindChunk(cx + nx, cz + nz)) ThawChunk({ cx + nx, cz + nz });
+        }
+    }
+}
+
+bool ChunkManager::DecodeColdChunk(const ColdChunk& cold, Chunk& chunk) {
+    size_t pos = 0;
+    pos = RleDecode(cold.data, pos, (unsigned char*)chunk.blocks, sizeof(chunk.blocks));
+    if (pos) pos = RleDecode(cold.data, pos, &chunk.light[0][0][0], sizeof(chunk.light));
+    if (pos) pos = RleDecode(cold.data, pos, &chunk.heightMap[0][0], sizeof(chunk.heightMap));
+    if (pos) pos = RleDecode(cold.data, pos, (unsigned char*)chunk.biomeMap, sizeof(chunk.biomeMap));
+    if (pos) pos = RleDecode(cold.data, pos, &chunk.sunHeight[0][0], sizeof(chunk.sunHeight));
+    return pos != 0;
+}
+
+/**
+ * drops the oldest unedited cold chunks (they generate again the same) until
+ * the tier fits in what CHUNK_MEMORY_MB leaves after the chunk storage
+ */
+void ChunkManager::TrimColdTier() {
+    size_t budget = (size_t)CHUNK_MEMORY_MB * 1024 * 1024;
+    size_t storage = (size_t)pool.GetAllocations() * sizeof(Chunk);
+    size_t limit = budget > storage ? budget - storage : 0;
+
+    while (coldBytes > limit && !coldOrder.empty()) {
+        std::pair<unsigned long long, ChunkCoord> entry = coldOrder.front();
+        coldOrder.pop_front();
+        auto it = coldChunks.find(entry.second);
+        if (it == coldChunks.end() || it->second.frozenAt != entry.first) continue;
+        coldBytes -= it->second.data.size();
+        coldChunks.erase(it);
+        stats.evicted++;
+    }
+
+    // thawed chunks leave stale entries behind, don't let them pile up
+    if (coldOrder.size() > 2 * coldChunks.size() + 64) {
+        std::deque<std::pair<unsigned long long, ChunkCoord>> live;
+        for (const auto& entry : coldOrder) {
+            auto it = coldChunks.find(entry.second);
+            if (it != coldChunks.end() && it->second.frozenAt == entry.first) live.push_back(entry);
+        }
+        coldOrder.swap(live);
+    }
+}
+
+void ChunkManager::PredictMovement(Vector3 playerPos, Vector3 velocity) {
+    ChunkCoord center = { (int)floor(playerPos.x / CHUNK_SIZE), (int)floor(playerPos.z / CHUNK_SIZE) };
+    float speed = sqrtf(velocity.x * velocity.x + velocity.z * velocity.z);
+    Vector3 heading = { 0, 0, 0 };
+    if (speed >= PREFETCH_MIN_SPEED) heading = { velocity.x / speed, 0.0f, velocity.z / speed };
+
+    // same direction and chunk: the queue is still right
+    bool turned = heading.x * prefetchHeading.x + heading.z * prefetchHeading.z < PREFETCH_CANCEL_COS;
+    if (!turned && center.x == prefetchCenter.x && center.z == prefetchCenter.z) return;
+
+    if (turned) stats.prefetchCancelled += (int)prefetchQueue.size();
+    prefetchQueue.clear();
+    prefetchPath.clear();
+    prefetchHeading = heading;
+    prefetchCenter = center;
+    if (speed < PREFETCH_MIN_SPEED) return;
+
+    // the neighbourhood of every chunk crossed on the way, half a chunk at a time
+    std::vector<ChunkCoord> offsets;
+    RankOffsets(RENDER_DISTANCE + 1, heading, offsets);
+    std::map<ChunkCoord, size_t> queued;
+    ChunkCoord last = center;
+    float reach = speed * PREFETCH_SECONDS;
+    for (float distance = CHUNK_SIZE * 0.5f; distance <= reach; distance += CHUNK_SIZE * 0.5f) {
+        ChunkCoord ahead = {
+            (int)floor((playerPos.x + heading.x * distance) / CHUNK_SIZE),
+            (int)floor((playerPos.z + heading.z * distance) / CHUNK_SIZE)
+        };
+        if (ahead.x == last.x && ahead.z == last.z) continue;
+        last = ahead;
+        prefetchPath.push_back(ahead);
+
+        for (const ChunkCoord& offset : offsets) {
+            ChunkCoord coord = { ahead.x + offset.x, ahead.z + offset.z };
+            bool mesh = abs(offset.x) <= RENDER_DISTANCE && abs(offset.z) <= RENDER_DISTANCE;
+
+            // the ranked order already streams everything around the player
+            int nearX = abs(coord.x - center.x), nearZ = abs(coord.z - center.z);
+            if (nearX <= RENDER_DISTANCE && nearZ <= RENDER_DISTANCE) continue;
+            if (!mesh && nearX <= RENDER_DISTANCE + 1 && nearZ <= RENDER_DISTANCE + 1) continue;
+
+            auto it = queued.find(coord);
+            if (it != queued.end()) {
+                prefetchQueue[it->second].mesh |= mesh;
+                continue;
             }
-            for (int i = 1; i < (int)BlockType::COUNT; i++) {
-                if (chunk.layers[i].meshCount > 0) {
-                    chunk.layers[i].materials[0].shader = shader;
-                    DrawModel(chunk.layers[i], { 0,0,0 }, 1.0f, tint);
+            const Chunk* chunk = FindChunk(coord.x, coord.z);
+            if (chunk && (!mesh || chunk->state == ChunkState::MESHED)) continue;
+            queued[coord] = prefetchQueue.size();
+            prefetchQueue.push_back({ coord, mesh });
+        }
+    }
+}
+
+void ChunkManager::UpdateAndDraw(Vector3 playerPos, Vector3 viewDir, Texture2D* textures, Shader shader, Color tint) {
+    PROFILE_SCOPE(ProfileZone::WORLD_DRAW);
+
+    StreamChunks(playerPos, viewDir, textures);
+
+    // water is drawn after everything opaque, farthest chunk first
+    std::vector<std::pair<float, Model*>> translucent;
+
+    // opaque chunks go nearest first, so depth testing rejects more of what follows
+    for (const ChunkCoord& offset : scheduleOrder) {
+        if (abs(offset.x) > RENDER_DISTANCE || abs(offset.z) > RENDER_DISTANCE) continue;
+        int cx = scheduleCenter.x + offset.x;
+        int cz = scheduleCenter.z + offset.z;
+        Chunk* found = FindChunk(cx, cz);
+        if (!found || found->state != ChunkState::MESHED) continue;
+        Chunk& chunk = *found;
+        if (!chunk.hasBeenDrawn) RecordDrawLatency(chunk);
+
+        for (int i = 1; i < (int)BlockType::COUNT; i++) {
+            if (chunk.layers[i].meshCount > 0) {
+                chunk.layers[i].materials[0].shader = shader;
+                if (i == (int)BlockType::WATER) {
+                    float dx = (cx + 0.5f) * CHUNK_SIZE - playerPos.x;
+                    float dz = (cz + 0.5f) * CHUNK_SIZE - playerPos.z;
+                    translucent.push_back({ dx * dx + dz * dz, &chunk.layers[i] });
+                    continue;
                 }
+                DrawModel(chunk.layers[i], { 0,0,0 }, 1.0f, tint);
             }
         }
     }
+
+    // blended, no depth writes so water behind water still shows,
+    // both sides so the surface is visible from below
+    std::sort(translucent.begin(), translucent.end(),
+        [](const std::pair<float, Model*>& a, const std::pair<float, Model*>& b) { return a.first > b.first; });
+    BeginBlendMode(BLEND_ALPHA);
+    rlDisableDepthMask();
+    rlDisableBackfaceCulling();
+    for (const auto& entry : translucent) DrawModel(*entry.second, { 0,0,0 }, 1.0f, tint);
+    rlEnableBackfaceCulling();
+    rlEnableDepthMask();
+    EndBlendMode();
+}
+
+/**
+ * the streaming half of UpdateAndDraw for runs without a window:
+ * generates chunks in range and builds their meshes on the cpu only
+ */
+void ChunkManager::UpdateHeadless(Vector3 playerPos, Vector3 viewDir) {
+    PROFILE_SCOPE(ProfileZone::WORLD_DRAW);
+
+    StreamChunks(playerPos, viewDir, nullptr);
+
+    // nothing is drawn, count a chunk as shown once it has a mesh
+    for (const ChunkCoord& offset : scheduleOrder) {
+        if (abs(offset.x) > RENDER_DISTANCE || abs(offset.z) > RENDER_DISTANCE) continue;
+        Chunk* chunk = FindChunk(scheduleCenter.x + offset.x, scheduleCenter.z + offset.z);
+        if (chunk && chunk->state == ChunkState::MESHED && !chunk->hasBeenDrawn) RecordDrawLatency(*chunk);
+    }
+}
+
+/**
+ * files the request -> first draw time of a chunk into the histogram
+ */
+void ChunkManager::RecordDrawLatency(Chunk& chunk) {
+    chunk.hasBeenDrawn = true;
+
+    double latency = Profiler::NowMs() - chunk.requestTime;
+    int bucket = 0;
+    while (bucket < LATENCY_BUCKETS - 1 && latency >= (double)(1 << bucket)) bucket++;
+
+    stats.latencyBuckets[bucket]++;
+    stats.latencyCount++;
+    stats.latencyTotalMs += latency;
+}
+
+/**
+ * recounts residency, queue depths and memory (keeps the latency histogram)
+ */
+void ChunkManager::RefreshStats(int pendingGenerate) {
+    stats.resident = (int)chunks.size();
+    stats.pendingGenerate = pendingGenerate;
+    stats.waiting = 0;
+    stats.pendingMesh = 0;
+    stats.dirty = 0;
+    stats.gpuBytes = 0;
+    stats.physicsCells = 0;
+    stats.fluidCells = 0;
+    stats.pooled = pool.GetFreeCount();
+    stats.chunkAllocations = pool.GetAllocations();
+    stats.coldChunks = (int)coldChunks.size();
+    stats.coldBytes = coldBytes;
+    stats.cpuBytes = (chunks.size() + stats.pooled) * sizeof(Chunk) + coldBytes;
+
+    for (const auto& pair : chunks) {
+        const Chunk& chunk = *pair.second;
+        if (chunk.state == ChunkState::WAITING) stats.waiting++;
+        else if (chunk.dirtySections) {
+            if (chunk.state == ChunkState::MESHED) stats.dirty++;
+            else stats.pendingMesh++;
+        }
+        stats.gpuBytes += chunk.gpuBytes;
+        stats.physicsCells += (int)chunk.activeCells.size();
+        stats.fluidCells += (int)chunk.fluidFrontier.size();
+        stats.cpuBytes += chunk.meshData.CapacityBytes();
+    }
+    stats.physicsChunks = (int)activeChunks.size();
+    stats.fluidChunks = (int)fluidChunks.size();
+}
+
+float ChunkStats::LatencyPercentile(float p) const {
+    if (latencyCount == 0) return 0.0f;
+
+    int target = (int)(p * latencyCount);
+    int seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += latencyBuckets[i];
+        if (seen > target) return (float)(1 << i);
+    }
+    return (float)(1 << (LATENCY_BUCKETS - 1));
 }
 
 /**
  * updates cellular automata processes (e.g. sand falling)
+ * every unsupported sand stack drops straight to where it lands in one tick,
+ * then each touched chunk is relit once and its remesh is left to the renderer
  */
 void ChunkManager::UpdateChunkPhysics() {
-    for (auto& pair : chunks) {
-        Chunk& chunk = pair.second;
-
-        // sleep check
-        if (!chunk.shouldStep) continue;
-
-        bool moved = false;
-
-        // scan loops
-        for (int x = 0; x < CHUNK_SIZE; x++) {
-            for (int z = 0; z < CHUNK_SIZE; z++) {
-                for (int y = 0; y < CHUNK_SIZE; y++) {
-
-                    if (chunk.blocks[x][y][z] == BlockType::SAND) {
-                        if (y > 0) {
-                            if (chunk.blocks[x][y - 1][z] == BlockType::AIR) {
-                                // swap
-                                chunk.blocks[x][y - 1][z] = BlockType::SAND;
-                                chunk.blocks[x][y][z] = BlockType::AIR;
-                                moved = true;
-                            }
-                        }
+    PROFILE_SCOPE(ProfileZone::PHYSICS);
+
+    std::vector<ChunkCoord> awake(activeChunks.begin(), activeChunks.end());
+    activeChunks.clear();
+
+    // chunks that changed this tick, with the cells that moved
+    std::map<ChunkCoord, DirtyMasks> changed;
+    std::vector<uint32_t> cells;
+    for (const ChunkCoord& coord : awake) {
+        Chunk* found = FindChunk(coord.x, coord.z);
+        if (!found) continue;
+        Chunk& chunk = *found;
+
+        cells.clear();
+        cells.swap(chunk.activeCells);
+        std::sort(cells.begin(), cells.end());
+        cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+
+        // sorted keys visit each column bottom-up, so a stack always lands on
+        // the stacks below it that already fell this tick
+        for (size_t i = 0; i < cells.size(); i++) {
+            uint32_t column = cells[i] / CHUNK_SIZE;
+            int y = (int)(cells[i] % CHUNK_SIZE);
+            int z = (int)(column % CHUNK_SIZE);
+            int x = (int)(column / CHUNK_SIZE);
+
+            int landedY;
+            int top = DropSegment(chunk, x, y, z, landedY);
+            if (top < 0) continue;
+
+            // whatever it landed on (or next to) gets a block update
+            ScheduleAround(coord.x * CHUNK_SIZE + x, landedY, coord.z * CHUNK_SIZE + z);
+
+            // water it sank through now sits above it, and the cells it left may fill up
+            for (int sy = landedY; sy <= top; sy++) WakeFluids(coord.x * CHUNK_SIZE + x, sy, coord.z * CHUNK_SIZE + z);
+
+            // everything between the new bottom and the old top changed
+            DirtyMasks& dirty = changed[coord];
+            for (int sy = landedY; sy <= top; sy++) dirty.AddCell(x, sy, z);
+
+            // entries for the rest of the stack were handled by the drop
+            while (i + 1 < cells.size() && cells[i + 1] / CHUNK_SIZE == column && (int)(cells[i + 1] % CHUNK_SIZE) <= top) i++;
+        }
+    }
+
+    // one relight per chunk per tick, the touched sections are rebuilt on the next draw
+    for (auto& entry : changed) {
+        Chunk* chunk = FindChunk(entry.first.x, entry.first.z);
+        if (!chunk) continue;
+        RelightTracked(*chunk, lightBefore, entry.second);
+        ApplyDirty(*chunk, entry.first, entry.second);
+    }
+}
+
+void ChunkManager::UpdateBlockTicks() {
+    PROFILE_SCOPE(ProfileZone::BLOCK_TICKS);
+
+    // every behaviour edits through SetBlock: one relight per touched chunk
+    // per tick, however many ticks come due at once
+    runningTicks = true;
+    BeginEdit();
+    int budget = ticks.budget;
+    budget -= ticks.RunDue(*this, budget);
+
+    // random ticks, picking up at the chunk where the last tick ran out of budget
+    // (at least one chunk per tick so a tiny budget still makes progress)
+    auto it = chunks.lower_bound(randomTickCursor);
+    for (size_t visited = 0; visited < chunks.size(); visited++) {
+        if (it == chunks.end()) it = chunks.begin();
+        ChunkCoord coord = it->first;
+        Chunk& chunk = *it->second;
+
+        int sections = 0;
+        for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+            if (chunk.sectionCounts[s] > 0) sections++;
+        }
+        int cost = sections * RANDOM_TICKS_PER_SECTION;
+        if (cost > budget && visited > 0) break;
+        budget -= cost;
+
+        for (int s = 0; s < SECTIONS_PER_CHUNK; s++) {
+            if (chunk.sectionCounts[s] == 0) continue;
+            int sx = s / (SECTIONS_PER_AXIS * SECTIONS_PER_AXIS) * SECTION_SIZE;
+            int sy = s / SECTIONS_PER_AXIS % SECTIONS_PER_AXIS * SECTION_SIZE;
+            int sz = s % SECTIONS_PER_AXIS * SECTION_SIZE;
+
+            for (int i = 0; i < RANDOM_TICKS_PER_SECTION; i++) {
+                // 4 bits per axis (SECTION_SIZE is 16)
+                unsigned int r = ticks.NextRandom();
+                int x = sx + (int)(r & 15);
+                int y = sy + (int)((r >> 4) & 15);
+                int z = sz + (int)((r >> 8) & 15);
+
+                BlockBehaviour behaviour = ticks.GetRandomBehaviour(chunk.blocks[x][y][z]);
+                if (behaviour) behaviour(*this, coord.x * CHUNK_SIZE + x, y, coord.z * CHUNK_SIZE + z);
+            }
+        }
+        ++it;
+    }
+    if (it == chunks.end()) it = chunks.begin();
+    if (it != chunks.end()) randomTickCursor = it->first;
+    CommitEdit();
+    runningTicks = false;
+
+    ticks.Advance();
+}
+
+/**
+ * one cell whose water level changes this fluid tick (0 = drains to air)
+ */
+struct FluidChange {
+    uint32_t cell;
+    unsigned char level;
+};
+
+/**
+ * a chunk's share of a fluid tick. jobs only write their own chunk, anything
+ * that spills over a border is handed back in `spill` and queued afterwards
+ */
+struct FluidJob {
+    ChunkCoord coord;
+    Chunk* chunk;
+    const Chunk* neighbours[3][3];
+    std::vector<uint32_t> cells;
+    std::vector<FluidChange> changes;
+    std::vector<std::pair<ChunkCoord, uint32_t>> spill;
+    DirtyMasks dirty;
+    std::vector<unsigned char> lightBefore;
+    bool edited; // the chunk or one beside it was edited, so is this flow
+};
+
+static const int FLUID_SIDES[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+// a cell's level depends on its six neighbours and on what lies under its
+// four side neighbours, so a change has to wake all of these (self first)
+static const int FLUID_WAKE[11][3] = {
+    { 0, 0, 0 }, { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+    { 1, 1, 0 }, { -1, 1, 0 }, { 0, 1, 1 }, { 0, 1, -1 }
+};
+
+/**
+ * water level at a chunk-local cell that may lie in a neighbour
+ * 0 = air, -1 = solid or not loaded (water treats it as a wall)
+ */
+static int FluidAt(const Chunk* const neighbours[3][3], int x, int y, int z) {
+    if (y < 0) return -1;
+    if (y >= CHUNK_SIZE) return 0;
+
+    int nx = 1;
+    int nz = 1;
+    if (x < 0) { nx = 0; x += CHUNK_SIZE; }
+    else if (x >= CHUNK_SIZE) { nx = 2; x -= CHUNK_SIZE; }
+    if (z < 0) { nz = 0; z += CHUNK_SIZE; }
+    else if (z >= CHUNK_SIZE) { nz = 2; z -= CHUNK_SIZE; }
+
+    const Chunk* c = neighbours[nx][nz];
+    if (!c) return -1;
+
+    BlockType block = c->blocks[x][y][z];
+    if (block == BlockType::AIR) return 0;
+    if (block != BlockType::WATER) return -1;
+
+    auto level = c->fluidLevels.find(PackCell(x, y, z));
+    return level != c->fluidLevels.end() ? level->second : WATER_SOURCE_LEVEL;
+}
+
+/**
+ * the level a non-solid cell should have given its neighbours:
+ * water above makes falling water, supported water next to it spreads one
+ * level lower, and two sources around a cell on solid ground make a new source
+ */
+static int DesiredLevel(const Chunk* const neighbours[3][3], int x, int y, int z, int current) {
+    // sources never drain
+    if (current == WATER_SOURCE_LEVEL) return current;
+
+    int want = FluidAt(neighbours, x, y + 1, z) > 0 ? WATER_FALLING_LEVEL : 0;
+    int sources = 0;
+    for (int i = 0; i < 4; i++) {
+        int nx = x + FLUID_SIDES[i][0];
+        int nz = z + FLUID_SIDES[i][1];
+        int level = FluidAt(neighbours, nx, y, nz);
+        if (level <= 0) continue;
+        if (level == WATER_SOURCE_LEVEL) sources++;
+
+        // water with air under it falls instead of spreading
+        if (FluidAt(neighbours, nx, y - 1, nz) == 0) continue;
+        want = std::max(want, level - 1);
+    }
+
+    if (sources >= 2) {
+        int below = FluidAt(neighbours, x, y - 1, z);
+        if (below < 0 || below == WATER_SOURCE_LEVEL) want = WATER_SOURCE_LEVEL;
+    }
+    return want;
+}
+
+void ChunkManager::UpdateFluids() {
+    if (++fluidTickCounter < FLUID_TICK_INTERVAL) return;
+    fluidTickCounter = 0;
+    StepFluids();
+}
+
+/**
+ * two phases so chunks never see each other half-updated: every job first
+ * works out its frontier's new levels from the current state (read only,
+ * neighbours included), then each job applies its own changes and relights
+ * its own chunk. cross-border wakeups are merged in chunk order at the end,
+ * so the result doesn't depend on how the jobs were scheduled
+ */
+void ChunkManager::StepFluids() {
+    PROFILE_SCOPE(ProfileZone::FLUIDS);
+
+    std::vector<FluidJob> jobs;
+    jobs.reserve(fluidChunks.size());
+    for (const ChunkCoord& coord : fluidChunks) {
+        Chunk* chunk = FindChunk(coord.x, coord.z);
+        if (!chunk) continue;
+
+        jobs.emplace_back();
+        FluidJob& job = jobs.back();
+        job.coord = coord;
+        job.chunk = chunk;
+        for (int nx = -1; nx <= 1; nx++) {
+            for (int nz = -1; nz <= 1; nz++) {
+                job.neighbours[nx + 1][nz + 1] = FindChunk(coord.x + nx, coord.z + nz);
+            }
+        }
+        job.cells.swap(chunk->fluidFrontier);
+        job.edited = chunk->modified;
+        for (int i = 0; i < 4; i++) {
+            const Chunk* side = job.neighbours[1 + FLUID_SIDES[i][0]][1 + FLUID_SIDES[i][1]];
+            if (side && side->modified) job.edited = true;
+        }
+    }
+    fluidChunks.clear();
+
+    // 1. new levels from the old state
+    JobSystem::ParallelFor((int)jobs.size(), [&](int i) {
+        FluidJob& job = jobs[i];
+        std::sort(job.cells.begin(), job.cells.end());
+        job.cells.erase(std::unique(job.cells.begin(), job.cells.end()), job.cells.end());
+
+        for (uint32_t cell : job.cells) {
+            int y = (int)(cell % CHUNK_SIZE);
+            int z = (int)(cell / CHUNK_SIZE % CHUNK_SIZE);
+            int x = (int)(cell / CHUNK_SIZE / CHUNK_SIZE);
+
+            int current = FluidAt(job.neighbours, x, y, z);
+            if (current < 0) continue;
+
+            int want = DesiredLevel(job.neighbours, x, y, z, current);
+            if (want != current) job.changes.push_back({ cell, (unsigned char)want });
+        }
+    });
+
+    // 2. every job writes only its own chunk
+    JobSystem::ParallelFor((int)jobs.size(), [&](int i) {
+        FluidJob& job = jobs[i];
+        if (job.changes.empty()) return;
+        Chunk& chunk = *job.chunk;
+        if (job.edited) chunk.modified = true;
+
+        for (const FluidChange& change : job.changes) {
+            int y = (int)(change.cell % CHUNK_SIZE);
+            int z = (int)(change.cell / CHUNK_SIZE % CHUNK_SIZE);
+            int x = (int)(change.cell / CHUNK_SIZE / CHUNK_SIZE);
+
+            job.dirty.AddCell(x, y, z);
+            if (change.level == 0) {
+                WriteBlock(chunk, x, y, z, BlockType::AIR);
+            }
+            else {
+                if (chunk.blocks[x][y][z] != BlockType::WATER) WriteBlock(chunk, x, y, z, BlockType::WATER);
+                if (change.level == WATER_SOURCE_LEVEL) chunk.fluidLevels.erase(change.cell);
+                else chunk.fluidLevels[change.cell] = change.level;
+            }
+
+            // the cells that depend on this one react on the next tick
+            for (int n = 1; n < 11; n++) {
+                int nx = x + FLUID_WAKE[n][0];
+                int ny = y + FLUID_WAKE[n][1];
+                int nz = z + FLUID_WAKE[n][2];
+                if (ny < 0 || ny >= CHUNK_SIZE) continue;
+
+                if (nx >= 0 && nx < CHUNK_SIZE && nz >= 0 && nz < CHUNK_SIZE) {
+                    chunk.fluidFrontier.push_back(PackCell(nx, ny, nz));
+                    continue;
+                }
+                ChunkCoord other = { job.coord.x + (nx < 0 ? -1 : (nx >= CHUNK_SIZE ? 1 : 0)),
+                                     job.coord.z + (nz < 0 ? -1 : (nz >= CHUNK_SIZE ? 1 : 0)) };
+                nx = (nx + CHUNK_SIZE) % CHUNK_SIZE;
+                nz = (nz + CHUNK_SIZE) % CHUNK_SIZE;
+                job.spill.push_back({ other, PackCell(nx, ny, nz) });
+            }
+        }
+
+        RelightTracked(chunk, job.lightBefore, job.dirty);
+    });
+
+    // 3. bookkeeping that touches shared state, in chunk order
+    for (FluidJob& job : jobs) {
+        Chunk& chunk = *job.chunk;
+        if (!chunk.fluidFrontier.empty()) fluidChunks.insert(job.coord);
+
+        for (const auto& spill : job.spill) {
+            Chunk* other = FindChunk(spill.first.x, spill.first.z);
+            if (!other) continue;
+            uint32_t cell = spill.second;
+            ActivateFluid(*other, spill.first, (int)(cell / CHUNK_SIZE / CHUNK_SIZE), (int)(cell % CHUNK_SIZE), (int)(cell / CHUNK_SIZE % CHUNK_SIZE));
+        }
+
+        if (job.changes.empty()) continue;
+        ApplyDirty(chunk, job.coord, job.dirty);
+
+        // sand that was floating on the water falls now
+        for (const FluidChange& change : job.changes) {
+            if (change.level != 0) continue;
+            int y = (int)(change.cell % CHUNK_SIZE);
+            int z = (int)(change.cell / CHUNK_SIZE % CHUNK_SIZE);
+            int x = (int)(change.cell / CHUNK_SIZE / CHUNK_SIZE);
+            if (y + 1 < CHUNK_SIZE && chunk.blocks[x][y + 1][z] == BlockType::SAND) {
+                ActivateCell(chunk, job.coord, x, y + 1, z);
+            }
+        }
+    }
+}
+
+void ChunkManager::ActivateFluid(Chunk& chunk, ChunkCoord coord, int x, int y, int z) {
+    if (y < 0 || y >= CHUNK_SIZE) return;
+    if (chunk.fluidFrontier.empty()) fluidChunks.insert(coord);
+    chunk.fluidFrontier.push_back(PackCell(x, y, z));
+}
+
+/**
+ * puts a world cell and everything whose flow depends on it on the fluid
+ * frontier (loaded chunks only)
+ */
+void ChunkManager::WakeFluids(int x, int y, int z) {
+    for (int i = 0; i < 11; i++) {
+        int nx = x + FLUID_WAKE[i][0];
+        int ny = y + FLUID_WAKE[i][1];
+        int nz = z + FLUID_WAKE[i][2];
+
+        int cx = ChunkOf(nx);
+        int cz = ChunkOf(nz);
+        Chunk* chunk = FindChunk(cx, cz);
+        if (!chunk) continue;
+
+        ActivateFluid(*chunk, { cx, cz }, nx - cx * CHUNK_SIZE, ny, nz - cz * CHUNK_SIZE);
+    }
+}
+
+/**
+ * queues the cells where water can start moving: flowing water (from a save),
+ * and air next to water, on both sides of the faces shared with loaded neighbours
+ */
+void ChunkManager::SeedFluids(Chunk& chunk, ChunkCoord coord) {
+    for (const auto& level : chunk.fluidLevels) {
+        uint32_t cell = level.first;
+        ActivateFluid(chunk, coord, (int)(cell / CHUNK_SIZE / CHUNK_SIZE), (int)(cell % CHUNK_SIZE), (int)(cell / CHUNK_SIZE % CHUNK_SIZE));
+    }
+
+    Chunk* neighbours[4];
+    for (int i = 0; i < 4; i++) neighbours[i] = FindChunk(coord.x + FLUID_SIDES[i][0], coord.z + FLUID_SIDES[i][1]);
+
+    // this chunk's water into air here or next door
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            for (int y = 0; y <= chunk.heightMap[x][z]; y++) {
+                if (chunk.blocks[x][y][z] != BlockType::WATER) continue;
+                if (y > 0 && chunk.blocks[x][y - 1][z] == BlockType::AIR) ActivateFluid(chunk, coord, x, y - 1, z);
+
+                for (int i = 0; i < 4; i++) {
+                    int nx = x + FLUID_SIDES[i][0];
+                    int nz = z + FLUID_SIDES[i][1];
+                    if (nx >= 0 && nx < CHUNK_SIZE && nz >= 0 && nz < CHUNK_SIZE) {
+                        if (chunk.blocks[nx][y][nz] == BlockType::AIR) ActivateFluid(chunk, coord, nx, y, nz);
+                        continue;
+                    }
+                    Chunk* other = neighbours[i];
+                    nx = (nx + CHUNK_SIZE) % CHUNK_SIZE;
+                    nz = (nz + CHUNK_SIZE) % CHUNK_SIZE;
+                    if (other && other->blocks[nx][y][nz] == BlockType::AIR) {
+                        ActivateFluid(*other, { coord.x + FLUID_SIDES[i][0], coord.z + FLUID_SIDES[i][1] }, nx, y, nz);
                     }
                 }
             }
         }
+    }
 
-        if (moved) {
-            chunk.meshReady = false;
-            // keep awake
-            chunk.shouldStep = true;
+    // neighbours' water into air here
+    for (int i = 0; i < 4; i++) {
+        Chunk* other = neighbours[i];
+        if (!other) continue;
+        for (int t = 0; t < CHUNK_SIZE; t++) {
+            // (x, z) here and the touching column over there
+            int x = FLUID_SIDES[i][0] == 0 ? t : (FLUID_SIDES[i][0] > 0 ? CHUNK_SIZE - 1 : 0);
+            int z = FLUID_SIDES[i][1] == 0 ? t : (FLUID_SIDES[i][1] > 0 ? CHUNK_SIZE - 1 : 0);
+            int ox = (x + FLUID_SIDES[i][0] + CHUNK_SIZE) % CHUNK_SIZE;
+            int oz = (z + FLUID_SIDES[i][1] + CHUNK_SIZE) % CHUNK_SIZE;
+
+            for (int y = 0; y <= other->heightMap[ox][oz]; y++) {
+                if (other->blocks[ox][y][oz] == BlockType::WATER && chunk.blocks[x][y][z] == BlockType::AIR) {
+                    ActivateFluid(chunk, coord, x, y, z);
+                }
+            }
         }
-        else {
-            // go to sleep
-            chunk.shouldStep = false;
+    }
+}
+
+/**
+ * moves the sand stack starting at y down onto the first solid block
+ * whatever it sinks through (air, water) ends up on top of it
+ * returns the old top of the stack (landedY = new bottom), or -1 if nothing fell
+ */
+int ChunkManager::DropSegment(Chunk& chunk, int x, int y, int z, int& landedY) {
+    if (y == 0 || chunk.blocks[x][y][z] != BlockType::SAND) return -1;
+    if (IsSolid(chunk.blocks[x][y - 1][z])) return -1;
+
+    int top = y;
+    while (top + 1 < CHUNK_SIZE && chunk.blocks[x][top + 1][z] == BlockType::SAND) top++;
+
+    int rest = y - 1;
+    while (rest > 0 && !IsSolid(chunk.blocks[x][rest - 1][z])) rest--;
+    int height = top - y + 1;
+
+    BlockType path[CHUNK_SIZE];
+    int pathLevels[CHUNK_SIZE];
+    for (int sy = rest; sy < y; sy++) {
+        path[sy - rest] = chunk.blocks[x][sy][z];
+        auto level = chunk.fluidLevels.find(PackCell(x, sy, z));
+        pathLevels[sy - rest] = level != chunk.fluidLevels.end() ? level->second : 0;
+        if (level != chunk.fluidLevels.end()) chunk.fluidLevels.erase(level);
+        if (path[sy - rest] != BlockType::AIR) chunk.sectionCounts[SectionIndex(x, sy, z)]--;
+    }
+    for (int sy = rest; sy <= top; sy++) {
+        if (sy < rest + height) {
+            if (sy < y) chunk.sectionCounts[SectionIndex(x, sy, z)]++;
+            chunk.blocks[x][sy][z] = BlockType::SAND;
+            continue;
         }
+        if (sy >= y) chunk.sectionCounts[SectionIndex(x, sy, z)]--;
+
+        int from = sy - height - rest;
+        chunk.blocks[x][sy][z] = path[from];
+        if (path[from] != BlockType::AIR) chunk.sectionCounts[SectionIndex(x, sy, z)]++;
+        if (pathLevels[from] > 0) chunk.fluidLevels[PackCell(x, sy, z)] = (unsigned char)pathLevels[from];
+    }
+    landedY = rest;
+
+    // only the top of the stack can have been the column top
+    unsigned char& columnTop = chunk.heightMap[x][z];
+    if (columnTop == top) {
+        while (columnTop > 0 && chunk.blocks[x][columnTop][z] == BlockType::AIR) columnTop--;
+    }
+    unsigned char& sun = chunk.sunHeight[x][z];
+    if (sun == top + 1) {
+        while (sun > 0 && !BlocksSunlight(chunk.blocks[x][sun - 1][z])) sun--;
     }
+    RebuildColumn(chunk, x, z);
+    return top;
+}
+
+int ChunkManager::GetSurfaceHeight(int x, int z) {
+    int cx = ChunkOf(x);
+    int cz = ChunkOf(z);
+
+    Chunk* chunk = FindChunk(cx, cz);
+    if (!chunk) chunk = ThawChunk({ cx, cz });
+    if (!chunk) return WorldGenerator::GetSurfaceHeight(x, z);
+
+    return chunk->heightMap[x - cx * CHUNK_SIZE][z - cz * CHUNK_SIZE];
 }
 
 int ChunkManager::GetLightLevel(int x, int y, int z) {
     if (y < 0 || y >= CHUNK_SIZE) return 15; // Sky is 15
 
-    int cx = (int)floor((float)x / CHUNK_SIZE);
-    int cz = (int)floor((float)z / CHUNK_SIZE);
-    ChunkCoord coord = { cx, cz };
+    int cx = ChunkOf(x);
+    int cz = ChunkOf(z);
 
     // If chunk doesnt exist, return 15 (Sun) or 0 (Darkness)
     // returning 0 is safer for preventing underground grid lines
-    if (chunks.find(coord) == chunks.end()) return 0;
+    Chunk* chunk = FindChunk(cx, cz);
+    if (!chunk) chunk = ThawChunk({ cx, cz });
+    if (!chunk) return 0;
 
-    int lx = ((x % CHUNK_SIZE) + CHUNK_SIZE) % CHUNK_SIZE;
-    int lz = ((z % CHUNK_SIZE) + CHUNK_SIZE) % CHUNK_SIZE;
-
-    return (int)chunks[coord].light[lx][y][lz];
+    return (int)chunk->light[x - cx * CHUNK_SIZE][y][z - cz * CHUNK_SIZE];
 }
 
 void ChunkManager::SaveChunks(std::ofstream& out) {
     // write how many chunks we have
-    size_t count = chunks.size();
+    size_t count = chunks.size() + coldChunks.size();
     out.write((char*)&count, sizeof(size_t));
 
     // loop through all chunks
     for (const auto& pair : chunks) {
         // write the Coordinate (x, z)
         out.write((char*)&pair.first, sizeof(ChunkCoord));
+        WriteChunkData(out, *pair.second);
+    }
+
+    // cold chunks are expanded one at a time into spare storage
+    if (coldChunks.empty()) return;
+    Chunk* scratch = pool.Acquire();
+    for (const auto& pair : coldChunks) {
+        out.write((char*)&pair.first, sizeof(ChunkCoord));
+        DecodeColdChunk(pair.second, *scratch);
+        scratch->fluidLevels = pair.second.fluidLevels;
+        WriteChunkData(out, *scratch);
+    }
+    pool.Release(scratch);
+}
+
+void ChunkManager::WriteChunkData(std::ostream& out, const Chunk& chunk) {
+    // write the Raw Block Data (64x64x64 bytes)
+    out.write((char*)chunk.blocks, sizeof(chunk.blocks));
 
-        // write the Raw Block Data (32x32x32 ints)
-        out.write((char*)pair.second.blocks, sizeof(pair.second.blocks));
+    // write the Raw Light Data (64x64x64 bytes)
+    out.write((char*)chunk.light, sizeof(chunk.light));
 
-        // write the Raw Light Data (32x32x32 bytes)
-        out.write((char*)pair.second.light, sizeof(pair.second.light));
+    // flowing water levels (cell key + level), sources aren't listed
+    uint32_t levels = (uint32_t)chunk.fluidLevels.size();
+    out.write((char*)&levels, sizeof(uint32_t));
+    for (const auto& level : chunk.fluidLevels) {
+        out.write((char*)&level.first, sizeof(uint32_t));
+        out.write((char*)&level.second, sizeof(unsigned char));
     }
 }
 
-void ChunkManager::LoadChunks(std::ifstream& in) {
+bool ChunkManager::ReadChunkData(std::istream& in, int version, Chunk& chunk) {
+    // read the Raw Data back into memory
+    in.read((char*)chunk.blocks, sizeof(chunk.blocks));
+    in.read((char*)chunk.light, sizeof(chunk.light));
+
+    // version 1 saves predate water
+    if (version >= 2) {
+        uint32_t levels = 0;
+        in.read((char*)&levels, sizeof(uint32_t));
+        for (uint32_t l = 0; l < levels && in; l++) {
+            uint32_t cell;
+            unsigned char level;
+            in.read((char*)&cell, sizeof(uint32_t));
+            in.read((char*)&level, sizeof(unsigned char));
+            chunk.fluidLevels[cell] = level;
+        }
+    }
+    return (bool)in;
+}
+
+void ChunkManager::LoadChunks(std::ifstream& in, int version) {
     // clear the current world
     UnloadAll();
 
@@ -498,26 +2012,52 @@ void ChunkManager::LoadChunks(std::ifstream& in) {
         ChunkCoord coord;
         in.read((char*)&coord, sizeof(ChunkCoord));
 
-        // create the chunk in the map
-        Chunk& chunk = chunks[coord];
+        // a save cut short keeps the chunks read so far
+        Chunk& chunk = *pool.Acquire();
+        if (!ReadChunkData(in, version, chunk)) {
+            pool.Release(&chunk);
+            break;
+        }
+        chunks[coord] = &chunk;
+        chunk.requestTime = Profiler::NowMs();
+        chunk.modified = true;
 
-        // read the Raw Data back into memory
-        in.read((char*)chunk.blocks, sizeof(chunk.blocks));
-        in.read((char*)chunk.light, sizeof(chunk.light));
+        // column caches aren't saved, derive them again
+        RebuildColumnData(chunk, coord.x, coord.z);
 
         // flag it to be rebuilt by the renderer
-        chunk.meshReady = false;
-        chunk.shouldStep = true;
+        chunk.dirtySections = ALL_SECTIONS;
+        SeedActiveCells(chunk, coord);
+        SeedFluids(chunk, coord);
+        RebuildOccupancy(chunk);
+        LinkNeighbours(chunk, coord);
     }
 }
 
-void ChunkManager::RebuildMesh(int cx, int cz, Texture2D* textures) {
+void ChunkManager::RefreshChunk(int cx, int cz) {
+    Chunk* chunk = FindChunk(cx, cz);
+    if (!chunk) return;
     ChunkCoord coord = { cx, cz };
-    if (chunks.find(coord) != chunks.end()) {
-        Chunk& chunk = chunks[coord];
-        // only build if needed
-        if (!chunk.meshReady) {
-            BuildChunkMesh(chunk, cx, cz, textures);
-        }
+
+    chunk->modified = true;
+    RebuildColumnData(*chunk, cx, cz);
+    RebuildOccupancy(*chunk);
+    ComputeChunkLighting(*chunk);
+    SeedActiveCells(*chunk, coord);
+    SeedFluids(*chunk, coord);
+
+    // the border faces of the neighbours may have changed as well
+    chunk->dirtySections = ALL_SECTIONS;
+    for (int i = 0; i < 4; i++) {
+        Chunk* other = FindChunk(cx + FLUID_SIDES[i][0], cz + FLUID_SIDES[i][1]);
+        if (other) other->dirtySections = ALL_SECTIONS;
+    }
+}
+
+void ChunkManager::RebuildMesh(int cx, int cz, Texture2D* textures) {
+    Chunk* chunk = FindChunk(cx, cz);
+    // only build if needed
+    if (chunk && chunk->state != ChunkState::WAITING && chunk->dirtySections) {
+        BuildChunkMesh(*chunk, cx, cz, textures);
     }
 }
\ No newline at end of file
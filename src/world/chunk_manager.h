@@ -4,9 +4,61 @@
 #include "raylib.h"
 #include "../core/constants.h"
 #include "../blocks/block_types.h"
+#include "block_ticks.h"
 #include <map>
+#include <set>
+#include <deque>
 #include <vector>
+#include <unordered_map>
+#include <cstdint>
 #include <fstream>
+#include <cstring>
+#include <memory>
+
+// 16^3 sections for random ticks and meshing (64 per chunk)
+#define SECTION_SIZE 16
+#define SECTIONS_PER_AXIS (CHUNK_SIZE / SECTION_SIZE)
+#define SECTIONS_PER_CHUNK (SECTIONS_PER_AXIS * SECTIONS_PER_AXIS * SECTIONS_PER_AXIS)
+
+// dirty mask with every section set (the whole chunk needs meshing)
+#define ALL_SECTIONS (~0ull)
+static_assert(SECTIONS_PER_CHUNK <= 64, "one dirty bit per section");
+
+// neighbour mask with all 8 surrounding chunks present
+#define ALL_NEIGHBOURS 0xFF
+
+/**
+ * mesh readiness of a chunk. border faces depend on the blocks next door,
+ * so a chunk waits until all 8 neighbours are generated and lit, is then
+ * meshed once, and after that only rebuilds the sections that go stale
+ */
+enum class ChunkState : unsigned char {
+    WAITING,  // generated and lit, some neighbours missing
+    READY,    // neighbours complete, not meshed yet
+    MESHED    // has a mesh, dirtySections says which parts are stale
+};
+
+/**
+ * cpu-side vertex data for a chunk mesh, one stream per render layer
+ */
+struct MeshBuffers {
+    std::vector<float> vertices[(int)BlockType::COUNT];
+    std::vector<float> texcoords[(int)BlockType::COUNT];
+    std::vector<unsigned char> colors[(int)BlockType::COUNT];
+
+    void Clear();
+    size_t VertexCount() const;
+    size_t CapacityBytes() const;
+};
+
+// position (3 floats) + uv (2 floats) + color (4 bytes) per uploaded vertex
+#define UPLOAD_VERTEX_BYTES (5 * sizeof(float) + 4)
+
+/**
+ * uploads one layer of triangles straight from the caller's streams, which
+ * stay the only cpu copy (unloading the model leaves them alone)
+ */
+Model UploadLayer(std::vector<float>& vertices, std::vector<float>& texcoords, std::vector<unsigned char>& colors);
 
 /**
  * generic 32x32x32 voxel container
@@ -16,24 +68,159 @@ struct Chunk {
     BlockType blocks[CHUNK_SIZE][CHUNK_SIZE][CHUNK_SIZE];
     unsigned char light[CHUNK_SIZE][CHUNK_SIZE][CHUNK_SIZE]; // packed light data
     Model layers[(int)BlockType::COUNT];
-    bool meshReady;
 
-    // physics flag (sleeping/awake)
-    bool shouldStep;
+    // vertex streams of every layer, section by section in index order, and
+    // how many faces of each layer a section holds. an edit re-emits only its
+    // own sections, splices them in and re-uploads only the layers they touch
+    MeshBuffers meshData;
+    unsigned short sectionFaces[SECTIONS_PER_CHUNK][(int)BlockType::COUNT];
+
+    // bit per section whose faces are out of date, 0 once the mesh is current
+    uint64_t dirtySections;
 
+    // a side neighbour arrived after the chunk was meshed, the next build
+    // is its border fix-up
+    bool borderFixPending;
+
+    // bit per generated neighbour (NEIGHBOUR_OFFSETS order in chunk_manager.cpp)
+    unsigned char neighbourMask;
+    ChunkState state;
+
+    // per-column cache: highest non-air block and biome
+    unsigned char heightMap[CHUNK_SIZE][CHUNK_SIZE];
+    BiomeType biomeMap[CHUNK_SIZE][CHUNK_SIZE];
+
+    // lowest y that direct sunlight reaches (one above the highest opaque or water block)
+    unsigned char sunHeight[CHUNK_SIZE][CHUNK_SIZE];
+
+    // cells that may be able to fall, packed with PackCell (see chunk_manager.cpp)
+    // empty means the chunk is asleep
+    std::vector<uint32_t> activeCells;
+
+    // levels of flowing water by PackCell key, water without an entry is a source
+    std::unordered_map<uint32_t, unsigned char> fluidLevels;
+
+    // cells whose water level may change on the next fluid tick
+    std::vector<uint32_t> fluidFrontier;
+
+    // non-air blocks per section, lets the random-tick sampler skip empty space
+    unsigned short sectionCounts[SECTIONS_PER_CHUNK];
+
+    // bit y set per column where the cell holds a block (anything but air
+    // and water) or water. the mesher culls faces a whole column at a time
+    uint64_t blockColumns[CHUNK_SIZE][CHUNK_SIZE];
+    uint64_t waterColumns[CHUNK_SIZE][CHUNK_SIZE];
+
+    // edited since it was generated (SetBlock outside block ticks, water
+    // flowing out of an edited chunk, RefreshChunk) or loaded from a save.
+    // such a chunk is never dropped from the cold tier. sand and water
+    // settling on their own come back when a chunk is generated again, but
+    // grass that spread or died by random tick is lost when an unedited
+    // chunk is dropped (those ticks follow the global random stream)
+    bool modified;
+
+    // streaming telemetry
+    double requestTime;   // profiler clock (ms) when the chunk was first asked for
+    bool hasBeenDrawn;    // request -> draw latency is recorded once
+    size_t gpuBytes;      // vertex data currently uploaded
+
+    // blocks and light are left uninitialised: generating or loading a
+    // chunk writes every cell
     Chunk() {
-        meshReady = false;
-        shouldStep = false; // default to asleep
-        for (int x = 0; x < CHUNK_SIZE; x++) {
-            for (int y = 0; y < CHUNK_SIZE; y++) {
-                for (int z = 0; z < CHUNK_SIZE; z++) {
-                    blocks[x][y][z] = BlockType::AIR;
-                    light[x][y][z] = 15;
-                }
-            }
-        }
         for (int i = 0; i < (int)BlockType::COUNT; i++) layers[i] = { 0 };
+        Reset();
     }
+
+    /**
+     * back to a new chunk's bookkeeping so the pool can hand it out again
+     * (models must be unloaded first, vectors keep their capacity)
+     */
+    void Reset();
+};
+
+/**
+ * sections whose faces need rebuilding after a change: bits for the chunk
+ * itself and for the sections next door across each side (+x, -x, +z, -z)
+ */
+struct DirtyMasks {
+    uint64_t own = 0;
+    uint64_t sides[4] = { 0, 0, 0, 0 };
+
+    /**
+     * a changed cell: its own section plus any section across a border it
+     * touches (its neighbours' faces against it live there)
+     */
+    void AddCell(int x, int y, int z);
+};
+
+// chunks generated and meshed for the first time per frame, best ranked
+// first (chunks that are already meshed rebuild their stale sections
+// right away so edits never lag)
+#define GENERATE_BUDGET 2
+#define MESH_BUDGET 4
+
+// view directions are bucketed into this many sectors for the streaming order
+#define SCHEDULE_SECTORS 8
+
+// chunks the player will reach within this many seconds at its current
+// velocity are generated and meshed ahead with budget the ranked order
+// leaves over, when moving faster than PREFETCH_MIN_SPEED blocks a second
+#define PREFETCH_SECONDS 5.0f
+#define PREFETCH_MIN_SPEED 2.0f
+
+// a turn sharper than this (cosine of the angle) cancels the queued prefetches
+#define PREFETCH_CANCEL_COS 0.9f
+
+// chunks further than this many chunks past the generated ring leave the
+// simulation when the player changes chunk (unless they lie ahead on the
+// predicted path): they are compressed into the cold tier and their storage
+// goes back to the pool
+#define COLD_MARGIN 1
+
+// cold chunks coming back into range are thawed up to this many per frame,
+// on top of GENERATE_BUDGET (thawing costs a fraction of generating)
+#define THAW_BUDGET 16
+
+// request -> drawn latency histogram, bucket i holds [2^(i-1), 2^i) ms
+#define LATENCY_BUCKETS 12
+
+/**
+ * chunk streaming counters for the debug overlay and telemetry csv
+ */
+struct ChunkStats {
+    int resident;          // chunks held in memory
+    int pendingGenerate;   // inside render distance, not generated yet
+    int waiting;           // generated, neighbours still missing
+    int pendingMesh;       // neighbours complete, never meshed
+    int dirty;             // meshed before, invalidated by an edit or physics
+    size_t cpuBytes;       // chunk data and cached faces in ram
+    size_t gpuBytes;       // uploaded vertex data
+    int physicsChunks;     // chunks with unstable cells
+    int physicsCells;      // cells queued for the next physics tick
+    int fluidChunks;       // chunks with flowing water
+    int fluidCells;        // cells queued for the next fluid tick
+
+    int firstMeshes;       // chunks meshed for the first time so far (again after a thaw)
+    int borderFixups;      // meshed chunks rebuilt after a side neighbour arrived so far
+    int meshRebuilds;      // meshed chunks rebuilt after edits, physics, water or ticks so far
+    int missedChunks;      // chunks that entered render distance without a mesh so far
+    int prefetched;        // chunks generated ahead along the predicted path so far
+    int prefetchCancelled; // queued prefetches dropped by a turn or a stop so far
+    int pooled;            // chunk storage waiting to be reused
+    int chunkAllocations;  // chunks the pool had to allocate so far
+    int coldChunks;        // compressed chunks outside the simulation
+    size_t coldBytes;      // their compressed size
+    int thawed;            // cold chunks expanded again so far
+    int evicted;           // unedited cold chunks dropped over the memory budget so far
+
+    int latencyBuckets[LATENCY_BUCKETS];
+    int latencyCount;
+    double latencyTotalMs;
+
+    /**
+     * approximate percentile (bucket upper bound) in ms
+     */
+    float LatencyPercentile(float p) const;
 };
 
 /**
@@ -47,6 +234,28 @@ struct ChunkCoord {
     }
 };
 
+/**
+ * recycles chunk storage: frozen chunks go on a free list and the next
+ * chunk generated or loaded takes one from there, so streaming only
+ * allocates until the window around the player is full
+ */
+class ChunkPool {
+public:
+    /**
+     * a chunk with fresh bookkeeping, blocks and light hold whatever was there before
+     */
+    Chunk* Acquire();
+    void Release(Chunk* chunk);
+
+    int GetAllocations() const { return allocations; }
+    int GetFreeCount() const { return (int)freeList.size(); }
+
+private:
+    std::vector<std::unique_ptr<Chunk>> storage;
+    std::vector<Chunk*> freeList;
+    int allocations = 0;
+};
+
 /**
  * node for lighting bfs queue
  */
@@ -64,27 +273,141 @@ public:
     void UnloadAll();
 
     /**
-     * renders visible chunks and handles loading logic
+     * streams chunks in and draws the meshed ones, nearest first. chunks are
+     * generated one ring past RENDER_DISTANCE so the ones drawn have all
+     * their neighbours. generation and first meshes are limited to
+     * GENERATE_BUDGET / MESH_BUDGET per frame, ranked by distance and by
+     * how close they are to `viewDir` (zero = no preference)
      */
-    void UpdateAndDraw(Vector3 playerPos, Texture2D* textures, Shader shader, Color tint);
+    void UpdateAndDraw(Vector3 playerPos, Vector3 viewDir, Texture2D* textures, Shader shader, Color tint);
 
     /**
-     * triggers a mesh rebuild for a specific chunk
+     * same streaming as UpdateAndDraw but meshes on the cpu only (no window needed)
+     */
+    void UpdateHeadless(Vector3 playerPos, Vector3 viewDir = { 0, 0, 0 });
+
+    /**
+     * queues the chunks the player will reach within PREFETCH_SECONDS at
+     * `velocity` (blocks per second), streamed by the next UpdateAndDraw.
+     * the queue is re-predicted when the player changes chunk, a turn or
+     * a stop cancels what it still holds
+     */
+    void PredictMovement(Vector3 playerPos, Vector3 velocity);
+
+    /**
+     * every chunk offset within `radius` (square), best first: nearer is
+     * better and chunks off to the side or behind `viewDir` rank as if they
+     * were up to twice as far away (the 3x3 around the player never is)
+     */
+    static void RankOffsets(int radius, Vector3 viewDir, std::vector<ChunkCoord>& out);
+
+    /**
+     * builds a chunk's mesh if it is stale and its neighbours are all there
+     * (chunks still waiting for neighbours are skipped)
      */
     void RebuildMesh(int cx, int cz, Texture2D* textures);
 
     /**
      * updates block physics (e.g. falling sand)
+     * only cells in the active sets are visited, idle chunks cost nothing
      */
     void UpdateChunkPhysics();
 
+    /**
+     * runs due scheduled block ticks, then random ticks over non-empty
+     * sections, round-robin across chunks within ticks.budget
+     */
+    void UpdateBlockTicks();
+    BlockTickScheduler& GetTicks() { return ticks; }
+
+    /**
+     * called every physics tick, steps the water every FLUID_TICK_INTERVAL ticks
+     */
+    void UpdateFluids();
+
+    /**
+     * one water step: every frontier cell pulls its new level from its
+     * neighbours (in parallel, one job per chunk), then all changes are applied
+     */
+    void StepFluids();
+    size_t GetActiveFluidChunks() const { return fluidChunks.size(); }
+
+    /**
+     * chunk lookup by chunk coords, nullptr if not loaded (never generates,
+     * and cold chunks count as not loaded)
+     */
+    Chunk* FindChunk(int cx, int cz);
+    const Chunk* FindChunk(int cx, int cz) const;
+
+    /**
+     * returns the chunk, thawing it from the cold tier or generating and
+     * lighting it first if needed
+     */
+    Chunk& GetOrCreateChunk(int cx, int cz);
+
+    /**
+     * generates and lights the missing chunks of `coords` on the job system,
+     * then hooks them up in list order on this thread (same world as calling
+     * GetOrCreateChunk on each in turn)
+     */
+    void GenerateBatch(const std::vector<ChunkCoord>& coords);
+    size_t GetChunkCount() const;
+    size_t GetActivePhysicsChunks() const { return activeChunks.size(); }
+
+    /**
+     * re-derives column caches, physics/fluid queues and light after the
+     * chunk's blocks were written directly (tools and benchmarks)
+     */
+    void RefreshChunk(int cx, int cz);
+
+    /**
+     * streaming telemetry, refreshed every UpdateAndDraw
+     */
+    const ChunkStats& GetStats() const { return stats; }
+
+    /**
+     * cpu half of BuildChunkMesh (culling + vertex streams, no gpu upload)
+     */
+    void BuildMeshData(int cx, int cz, MeshBuffers& out);
+
+    /**
+     * flood-fills sun and torch light inside a single chunk
+     */
+    void ComputeChunkLighting(Chunk& chunk);
+
+    /**
+     * block at world coords. a cold chunk is thawed first, a missing one is
+     * generated unless `createIfMissing` is false (then it reads as air)
+     */
     BlockType GetBlock(int x, int y, int z, bool createIfMissing = true);
+
+    /**
+     * light at world coords, a cold chunk is thawed first, a missing one reads as dark
+     */
     int GetLightLevel(int x, int y, int z);
+
+    /**
+     * y of the highest non-air block in a world column
+     * uses the chunk heightmap when loaded (cold chunks are thawed), terrain noise otherwise
+     */
+    int GetSurfaceHeight(int x, int z);
     
     /**
      * changes a block and updates neighbors/lighting
+     * inside BeginEdit/CommitEdit the relight and remesh wait for the commit
      */
     void SetBlock(int x, int y, int z, BlockType type);
+
+    /**
+     * batches SetBlock calls: until the matching CommitEdit they only write
+     * blocks and wake physics, ticks and water. CommitEdit relights every
+     * touched chunk once. the sections whose blocks or light changed (and
+     * the ones across their borders, next door too) are marked dirty, and
+     * the next draw re-scans just those.
+     * edits can nest, only the outermost CommitEdit applies them
+     */
+    void BeginEdit();
+    void CommitEdit();
     bool IsBlockSolid(int x, int y, int z);
 
     /**
@@ -93,17 +416,110 @@ public:
     void SaveChunks(std::ofstream& out);
 
     /**
-     * reads world data from disk
+     * reads world data from disk, `version` is the save header's
      */
-    void LoadChunks(std::ifstream& in);
+    void LoadChunks(std::ifstream& in, int version = SAVE_VERSION);
+
+    /**
+     * what a save keeps of a chunk after its coordinate: blocks, light and
+     * water levels (SaveChunks writes the count and coordinates around it)
+     */
+    static void WriteChunkData(std::ostream& out, const Chunk& chunk);
+
+    /**
+     * reads that back into a fresh chunk, false if the stream ends part way
+     */
+    static bool ReadChunkData(std::istream& in, int version, Chunk& chunk);
 
 private:
-    std::map<ChunkCoord, Chunk> chunks;
+    std::map<ChunkCoord, Chunk*> chunks;
+    ChunkPool pool;
+    ChunkStats stats = {};
+
+    // chunks with a non-empty activeCells list, ordered so ticks are deterministic
+    std::set<ChunkCoord> activeChunks;
+
+    // same for fluidFrontier
+    std::set<ChunkCoord> fluidChunks;
+    int fluidTickCounter = 0;
+
+    BlockTickScheduler ticks;
+    ChunkCoord randomTickCursor = { 0, 0 };
+
+    // chunks outside the simulation, compressed (see chunk_codec.h): blocks,
+    // light and column caches, plus the water levels as they were
+    struct ColdChunk {
+        std::vector<unsigned char> data;
+        std::unordered_map<uint32_t, unsigned char> fluidLevels;
+        bool modified;
+        unsigned long long frozenAt;
+    };
+    std::map<ChunkCoord, ColdChunk> coldChunks;
+    size_t coldBytes = 0;
+    std::vector<unsigned char> coldScratch;
+
+    // unedited cold chunks, oldest first, dropped first when over the budget
+    // (entries whose chunk was thawed or frozen again since are skipped)
+    std::deque<std::pair<unsigned long long, ChunkCoord>> coldOrder;
+    unsigned long long freezeCounter = 0;
+
+    // set while block behaviours run: grass spreading and dying doesn't count
+    // as an edit, or nearly every chunk would be pinned in memory. dropping
+    // such a chunk undoes it (see Chunk::modified)
+    bool runningTicks = false;
+
+    // streaming order (offsets from the player's chunk), only re-ranked when
+    // the player changes chunk or turns into another view sector
+    std::vector<ChunkCoord> scheduleOrder;
+    ChunkCoord scheduleCenter = { 0, 0 };
+    int scheduleSector = -1;
+    int scheduleRadius = -1;
+
+    // chunks ahead on the predicted path, nearest first. `mesh` entries
+    // will be inside render distance, the rest only complete their neighbours
+    struct PrefetchEntry {
+        ChunkCoord coord;
+        bool mesh;
+    };
+    std::vector<PrefetchEntry> prefetchQueue;
+    // the chunks the predicted path crosses, nearest first
+    std::vector<ChunkCoord> prefetchPath;
+    Vector3 prefetchHeading = { 0, 0, 0 };
+    ChunkCoord prefetchCenter = { 0, 0 };
+
+    // open edit: nesting depth and chunks to relight on commit
+    int editDepth = 0;
+    std::set<ChunkCoord> editRelight;
+    std::vector<unsigned char> lightBefore; // scratch for finding what a relight changed
 
     void GenerateChunk(Chunk& chunk, int chunkX, int chunkZ);
+    void AttachChunk(Chunk& chunk, ChunkCoord coord);
+    void LinkNeighbours(Chunk& chunk, ChunkCoord coord);
+    void StreamChunks(Vector3 playerPos, Vector3 viewDir, Texture2D* textures);
+    void FreezeFarChunks(ChunkCoord center);
+    bool IsNearPath(ChunkCoord coord, ChunkCoord center, int radius) const;
+    void FreezeChunk(ChunkCoord coord, Chunk& chunk);
+    Chunk* ThawChunk(ChunkCoord coord);
+    void ThawAround(int cx, int cz);
+    void TrimColdTier();
+    static bool DecodeColdChunk(const ColdChunk& cold, Chunk& chunk);
     void BuildChunkMesh(Chunk& chunk, int cx, int cz, Texture2D* textures);
+    void BuildMeshData(const Chunk& chunk, int cx, int cz, MeshBuffers& out) const;
+    void GetMeshNeighbours(int cx, int cz, const Chunk* neighbours[3][3]) const;
+    void RelightTracked(Chunk& chunk, std::vector<unsigned char>& scratch, DirtyMasks& dirty);
+    void ApplyDirty(Chunk& chunk, ChunkCoord coord, const DirtyMasks& dirty);
     void UnloadChunkModels(Chunk& chunk);
-    void ComputeChunkLighting(Chunk& chunk);
+    void RebuildColumnData(Chunk& chunk, int chunkX, int chunkZ);
+    void ActivateCell(Chunk& chunk, ChunkCoord coord, int x, int y, int z);
+    void SeedActiveCells(Chunk& chunk, ChunkCoord coord);
+    void ActivateFluid(Chunk& chunk, ChunkCoord coord, int x, int y, int z);
+    void WakeFluids(int x, int y, int z);
+    void SeedFluids(Chunk& chunk, ChunkCoord coord);
+    int DropSegment(Chunk& chunk, int x, int y, int z, int& landedY);
+    void RebuildOccupancy(Chunk& chunk);
+    void ScheduleAround(int x, int y, int z);
+    void RecordDrawLatency(Chunk& chunk);
+    void RefreshStats(int pendingGenerate);
 };
 
 #endif
\ No newline at end of file
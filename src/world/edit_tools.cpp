@@ -0,0 +1,39 @@
+#include "edit_tools.h"
+#include "chunk_manager.h"
+#include "block_accessor.h"
+#include <algorithm>
+
+void FillBox(ChunkManager& world, int x0, int y0, int z0, int x1, int y1, int z1, BlockType type) {
+    if (x0 > x1) std::swap(x0, x1);
+    if (y0 > y1) std::swap(y0, y1);
+    if (z0 > z1) std::swap(z0, z1);
+    if (y0 < 0) y0 = 0;
+    if (y1 >= CHUNK_SIZE) y1 = CHUNK_SIZE - 1;
+
+    world.BeginEdit();
+    for (int x = x0; x <= x1; x++) {
+        for (int z = z0; z <= z1; z++) {
+            for (int y = y0; y <= y1; y++) world.SetBlock(x, y, z, type);
+        }
+    }
+    world.CommitEdit();
+}
+
+int Explode(ChunkManager& world, int x, int y, int z, int radius) {
+    BlockAccessor blocks(world);
+    int removed = 0;
+
+    world.BeginEdit();
+    for (int dx = -radius; dx <= radius; dx++) {
+        for (int dz = -radius; dz <= radius; dz++) {
+            for (int dy = -radius; dy <= radius; dy++) {
+                if (dx * dx + dy * dy + dz * dz > radius * radius) continue;
+                if (!IsSolid(blocks.Get(x + dx, y + dy, z + dz))) continue;
+                world.SetBlock(x + dx, y + dy, z + dz, BlockType::AIR);
+                removed++;
+            }
+        }
+    }
+    world.CommitEdit();
+    return removed;
+}
@@ -0,0 +1,22 @@
+#ifndef EDIT_TOOLS_H
+#define EDIT_TOOLS_H
+
+#include "../blocks/block_types.h"
+
+class ChunkManager;
+
+// blocks cleared around an explosion
+#define EXPLOSION_RADIUS 4
+
+/**
+ * sets every block in the inclusive box to `type` as a single edit
+ */
+void FillBox(ChunkManager& world, int x0, int y0, int z0, int x1, int y1, int z1, BlockType type);
+
+/**
+ * clears the solid blocks in a sphere as a single edit (water is left alone)
+ * returns how many blocks were removed
+ */
+int Explode(ChunkManager& world, int x, int y, int z, int radius);
+
+#endif
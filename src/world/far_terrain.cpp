@@ -0,0 +1,246 @@
+#include "far_terrain.h"
+#include "world_generator.h"
+#include "../core/job_system.h"
+#include "../core/profiler.h"
+#include <cmath>
+#include <algorithm>
+
+void FarMeshData::Clear() {
+    vertices.clear();
+    texcoords.clear();
+    colors.clear();
+}
+
+/**
+ * averages every block texture into one texel, a far triangle samples the
+ * texel of its surface block
+ */
+void FarTerrain::Init(Texture2D* blockTextures) {
+    Image image = GenImageColor((int)BlockType::COUNT, 1, BLACK);
+    for (int i = 1; i < (int)BlockType::COUNT; i++) {
+        Image source = LoadImageFromTexture(blockTextures[i]);
+        Color* pixels = LoadImageColors(source);
+        int count = source.width * source.height;
+        long sum[3] = { 0, 0, 0 };
+        for (int p = 0; p < count; p++) {
+            sum[0] += pixels[p].r;
+            sum[1] += pixels[p].g;
+            sum[2] += pixels[p].b;
+        }
+        if (count > 0) {
+            Color average = { (unsigned char)(sum[0] / count), (unsigned char)(sum[1] / count), (unsigned char)(sum[2] / count), 255 };
+            ImageDrawPixel(&image, i, 0, average);
+        }
+        UnloadImageColors(pixels);
+        UnloadImage(source);
+    }
+    palette = LoadTextureFromImage(image);
+    UnloadImage(image);
+}
+
+void FarTerrain::Unload() {
+    for (auto& pair : tiles) UnloadTile(pair.second);
+    tiles.clear();
+    if (palette.id > 0) UnloadTexture(palette);
+    palette = {};
+}
+
+void FarTerrain::UnloadTile(FarTile& tile) {
+    if (tile.model.meshCount > 0) UnloadModel(tile.model);
+    tile.model = {};
+    tile.gpuBytes = 0;
+}
+
+float FarTerrain::GetViewDistance() {
+    return (float)(RENDER_DISTANCE * CHUNK_SIZE * FAR_VIEW_MULTIPLIER);
+}
+
+void FarTerrain::GetNearBox(Vector3 playerPos, float box[4]) {
+    int playerCX = (int)floor(playerPos.x / CHUNK_SIZE);
+    int playerCZ = (int)floor(playerPos.z / CHUNK_SIZE);
+    box[0] = (float)((playerCX - RENDER_DISTANCE) * CHUNK_SIZE);
+    box[1] = (float)((playerCZ - RENDER_DISTANCE) * CHUNK_SIZE);
+    box[2] = (float)((playerCX + RENDER_DISTANCE + 1) * CHUNK_SIZE);
+    box[3] = (float)((playerCZ + RENDER_DISTANCE + 1) * CHUNK_SIZE);
+}
+
+int FarTerrain::GetTileStep(int ring) {
+    int step = FAR_MIN_STEP;
+    for (int r = ring; r > 2 && step < FAR_MAX_STEP; r /= 2) step *= 2;
+    return step;
+}
+
+/**
+ * top of the terrain (or lake surface) of a column and the block showing there
+ */
+static float SampleColumn(int x, int z, BlockType& surface) {
+    int height = WorldGenerator::GetColumnHeight(x, z);
+    if (height < SEA_LEVEL) {
+        surface = BlockType::WATER;
+        return SEA_LEVEL + (float)WATER_SOURCE_LEVEL / (WATER_SOURCE_LEVEL + 1);
+    }
+    surface = WorldGenerator::GetSurfaceBlock(WorldGenerator::GetBiome(x, z));
+    return (float)(height + 1);
+}
+
+/**
+ * one triangle, all three corners on the palette texel of `block`
+ */
+static void PushTriangle(FarMeshData& out, const float* corners, BlockType block, unsigned char shade) {
+    float u = ((float)block + 0.5f) / (float)BlockType::COUNT;
+    out.vertices.insert(out.vertices.end(), corners, corners + 9);
+    for (int k = 0; k < 3; k++) {
+        out.texcoords.push_back(u);
+        out.texcoords.push_back(0.5f);
+        // sun in red like the chunks, torch light off
+        unsigned char color[4] = { shade, 0, 0, 255 };
+        out.colors.insert(out.colors.end(), color, color + 4);
+    }
+}
+
+/**
+ * vertical strip from the edge a -> b down below both ends
+ */
+static void PushSkirt(FarMeshData& out, float ax, float ay, float az, float bx, float by, float bz, float depth, BlockType block) {
+    float bottom = std::min(ay, by) - depth;
+    float first[9] = { ax, ay, az, bx, by, bz, bx, bottom, bz };
+    float second[9] = { ax, ay, az, bx, bottom, bz, ax, bottom, az };
+    PushTriangle(out, first, block, 160);
+    PushTriangle(out, second, block, 160);
+}
+
+void FarTerrain::BuildTileMesh(int tileX, int tileZ, int step, FarMeshData& out) {
+    out.Clear();
+
+    int cells = FAR_TILE_SIZE / step;
+    int side = cells + 1;
+    int originX = tileX * FAR_TILE_SIZE;
+    int originZ = tileZ * FAR_TILE_SIZE;
+
+    std::vector<float> heights(side * side);
+    std::vector<BlockType> blocks(side * side);
+    for (int i = 0; i < side; i++) {
+        for (int j = 0; j < side; j++) {
+            heights[i * side + j] = SampleColumn(originX + i * step, originZ + j * step, blocks[i * side + j]);
+        }
+    }
+
+    for (int i = 0; i < cells; i++) {
+        for (int j = 0; j < cells; j++) {
+            float x0 = (float)(originX + i * step), x1 = x0 + step;
+            float z0 = (float)(originZ + j * step), z1 = z0 + step;
+            float h00 = heights[i * side + j];
+            float h10 = heights[(i + 1) * side + j];
+            float h01 = heights[i * side + j + 1];
+            float h11 = heights[(i + 1) * side + j + 1];
+
+            // steeper cells get less sun so the relief reads from afar
+            float dx = (h10 + h11 - h00 - h01) / (2.0f * step);
+            float dz = (h01 + h11 - h00 - h10) / (2.0f * step);
+            float up = 1.0f / sqrtf(1.0f + dx * dx + dz * dz);
+            unsigned char shade = (unsigned char)(255.0f * (0.55f + 0.45f * up));
+
+            // same winding as a chunk's top faces
+            BlockType block = blocks[i * side + j];
+            float first[9] = { x0, h01, z1, x1, h11, z1, x1, h10, z0 };
+            float second[9] = { x0, h01, z1, x1, h10, z0, x0, h00, z0 };
+            PushTriangle(out, first, block, shade);
+            PushTriangle(out, second, block, shade);
+        }
+    }
+
+    // skirts along the four edges cover the gaps to tiles sampled at another step
+    float depth = (float)step;
+    for (int k = 0; k < cells; k++) {
+        float a = (float)(k * step), b = a + step;
+        int last = cells;
+        PushSkirt(out, originX + a, heights[k * side], (float)originZ,
+            originX + b, heights[(k + 1) * side], (float)originZ, depth, blocks[k * side]);
+        PushSkirt(out, originX + a, heights[k * side + last], (float)(originZ + FAR_TILE_SIZE),
+            originX + b, heights[(k + 1) * side + last], (float)(originZ + FAR_TILE_SIZE), depth, blocks[k * side + last]);
+        PushSkirt(out, (float)originX, heights[k], originZ + a,
+            (float)originX, heights[k + 1], originZ + b, depth, blocks[k]);
+        PushSkirt(out, (float)(originX + FAR_TILE_SIZE), heights[last * side + k], originZ + a,
+            (float)(originX + FAR_TILE_SIZE), heights[last * side + k + 1], originZ + b, depth, blocks[last * side + k]);
+    }
+}
+
+size_t FarTerrain::GetGpuBytes() const {
+    size_t bytes = 0;
+    for (const auto& pair : tiles) bytes += pair.second.gpuBytes;
+    return bytes;
+}
+
+void FarTerrain::Update(Vector3 playerPos) {
+    PROFILE_SCOPE(ProfileZone::WORLD_DRAW);
+
+    int playerTX = (int)floor(playerPos.x / FAR_TILE_SIZE);
+    int playerTZ = (int)floor(playerPos.z / FAR_TILE_SIZE);
+    float view = GetViewDistance();
+    int radius = (int)ceil(view / FAR_TILE_SIZE);
+
+    // tiles completely under the chunks (past the fade band) are never seen
+    float nearBox[4];
+    GetNearBox(playerPos, nearBox);
+
+    struct Wanted { ChunkCoord coord; int step; int ring; };
+    std::vector<Wanted> wanted;
+    std::map<ChunkCoord, int> steps;
+    for (int tx = playerTX - radius; tx <= playerTX + radius; tx++) {
+        for (int tz = playerTZ - radius; tz <= playerTZ + radius; tz++) {
+            float minX = (float)(tx * FAR_TILE_SIZE), maxX = minX + FAR_TILE_SIZE;
+            float minZ = (float)(tz * FAR_TILE_SIZE), maxZ = minZ + FAR_TILE_SIZE;
+            if (minX >= nearBox[0] + FAR_FADE_WIDTH && maxX <= nearBox[2] - FAR_FADE_WIDTH &&
+                minZ >= nearBox[1] + FAR_FADE_WIDTH && maxZ <= nearBox[3] - FAR_FADE_WIDTH) continue;
+
+            float dx = std::max(std::max(minX - playerPos.x, playerPos.x - maxX), 0.0f);
+            float dz = std::max(std::max(minZ - playerPos.z, playerPos.z - maxZ), 0.0f);
+            if (dx * dx + dz * dz > view * view) continue;
+
+            int ring = std::max(std::abs(tx - playerTX), std::abs(tz - playerTZ));
+            ChunkCoord coord = { tx, tz };
+            steps[coord] = GetTileStep(ring);
+            auto it = tiles.find(coord);
+            if (it == tiles.end() || it->second.step != steps[coord]) wanted.push_back({ coord, steps[coord], ring });
+        }
+    }
+
+    for (auto it = tiles.begin(); it != tiles.end();) {
+        if (steps.count(it->first)) { ++it; continue; }
+        UnloadTile(it->second);
+        it = tiles.erase(it);
+    }
+
+    if (wanted.empty()) return;
+    std::sort(wanted.begin(), wanted.end(), [](const Wanted& a, const Wanted& b) { return a.ring < b.ring; });
+    if ((int)wanted.size() > FAR_BUILDS_PER_FRAME) wanted.resize(FAR_BUILDS_PER_FRAME);
+
+    // sampling the noise is the expensive part and touches nothing shared
+    std::vector<FarMeshData> meshes(wanted.size());
+    JobSystem::ParallelFor((int)wanted.size(), [&](int i) {
+        BuildTileMesh(wanted[i].coord.x, wanted[i].coord.z, wanted[i].step, meshes[i]);
+    });
+
+    for (size_t i = 0; i < wanted.size(); i++) {
+        FarTile& tile = tiles[wanted[i].coord];
+        UnloadTile(tile);
+        tile.step = wanted[i].step;
+
+        // no gl context (headless runs): keep the cpu work, skip the upload
+        FarMeshData& data = meshes[i];
+        if (!IsWindowReady() || data.vertices.empty()) continue;
+
+        tile.model = UploadLayer(data.vertices, data.texcoords, data.colors);
+        tile.model.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = palette;
+        tile.gpuBytes = (size_t)data.VertexCount() * UPLOAD_VERTEX_BYTES;
+    }
+}
+
+void FarTerrain::Draw(Shader shader, Color tint) {
+    for (auto& pair : tiles) {
+        Model& model = pair.second.model;
+        if (model.meshCount == 0) continue;
+        model.materials[0].shader = shader;
+        DrawModel(model, { 0, 0, 0 }, 1.0f, tint);
+    }
+}
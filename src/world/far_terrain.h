@@ -0,0 +1,103 @@
+#ifndef FAR_TERRAIN_H
+#define FAR_TERRAIN_H
+
+#include "raylib.h"
+#include "chunk_manager.h"
+#include "../core/constants.h"
+#include "../blocks/block_types.h"
+#include <map>
+#include <vector>
+
+// blocks per side of a far tile (4x4 chunks)
+#define FAR_TILE_SIZE 256
+
+// far terrain reaches this many times the chunk render distance
+#define FAR_VIEW_MULTIPLIER 10
+
+// height samples are this far apart next to the chunks, doubling per ring band out
+#define FAR_MIN_STEP 8
+#define FAR_MAX_STEP 64
+
+// blocks over which the edge chunks dither into the far terrain
+#define FAR_FADE_WIDTH 24.0f
+
+// tiles built per frame, nearest first
+#define FAR_BUILDS_PER_FRAME 8
+
+/**
+ * cpu side of one far tile: plain triangles in world space, one palette
+ * texel per triangle (uv) and the sun channel for slope shading (color)
+ */
+struct FarMeshData {
+    std::vector<float> vertices;
+    std::vector<float> texcoords;
+    std::vector<unsigned char> colors;
+
+    void Clear();
+    int VertexCount() const { return (int)vertices.size() / 3; }
+};
+
+/**
+ * one cached tile and the sample spacing it was built with
+ */
+struct FarTile {
+    Model model = {};
+    int step = 0;
+    size_t gpuBytes = 0;
+};
+
+/**
+ * low resolution terrain past the loaded chunks, built straight from the
+ * generator's height and biome noise (no voxels, no lighting). tiles get
+ * coarser the further out they are and are cached until they leave the
+ * view or need another resolution. the chunk shader's cross-fade hides
+ * whichever of the two is not meant to show near the edge of the chunks
+ */
+class FarTerrain {
+public:
+    /**
+     * builds the palette (average colour of every block texture)
+     */
+    void Init(Texture2D* blockTextures);
+    void Unload();
+
+    /**
+     * drops tiles out of view and builds up to FAR_BUILDS_PER_FRAME new ones
+     * (height sampling runs on the job system, uploads on this thread)
+     */
+    void Update(Vector3 playerPos);
+
+    void Draw(Shader shader, Color tint);
+
+    /**
+     * how far the far terrain reaches, in blocks
+     */
+    static float GetViewDistance();
+
+    /**
+     * xz bounds (minX, minZ, maxX, maxZ) of the chunks UpdateAndDraw draws
+     */
+    static void GetNearBox(Vector3 playerPos, float box[4]);
+
+    /**
+     * sample spacing for a tile `ring` tiles away from the player's tile
+     */
+    static int GetTileStep(int ring);
+
+    /**
+     * height field mesh of one tile with skirts hiding the cracks against
+     * coarser neighbours
+     */
+    static void BuildTileMesh(int tileX, int tileZ, int step, FarMeshData& out);
+
+    int GetTileCount() const { return (int)tiles.size(); }
+    size_t GetGpuBytes() const;
+
+private:
+    std::map<ChunkCoord, FarTile> tiles;
+    Texture2D palette = {};
+
+    void UnloadTile(FarTile& tile);
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "voxel_raycast.h"
+#include "chunk_manager.h"
+#include "block_accessor.h"
+#include <cmath>
+
+VoxelHit RaycastBlocks(ChunkManager& world, Vector3 origin, Vector3 direction, float maxDistance) {
+    VoxelHit result;
+
+    float length = sqrtf(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+    if (length <= 0.0f) return result;
+
+    float o[3] = { origin.x, origin.y, origin.z };
+    float d[3] = { direction.x / length, direction.y / length, direction.z / length };
+
+    int cell[3], step[3];
+    float tMax[3], tDelta[3];
+    for (int axis = 0; axis < 3; axis++) {
+        cell[axis] = (int)floorf(o[axis]);
+        step[axis] = d[axis] > 0.0f ? 1 : (d[axis] < 0.0f ? -1 : 0);
+        if (step[axis] == 0) {
+            tMax[axis] = INFINITY;
+            tDelta[axis] = INFINITY;
+            continue;
+        }
+        // ray distance to the first boundary on this axis, then between boundaries
+        float boundary = step[axis] > 0 ? (float)cell[axis] + 1.0f : (float)cell[axis];
+        tMax[axis] = (boundary - o[axis]) / d[axis];
+        tDelta[axis] = fabsf(1.0f / d[axis]);
+    }
+
+    // steps one cell at a time, so only chunk crossings hit the chunk map
+    BlockAccessor blocks(world);
+    blocks.Seek(cell[0], cell[1], cell[2]);
+
+    if (IsSolid(blocks.Current())) {
+        // inside a block: report the face behind the dominant direction
+        int major = 0;
+        if (fabsf(d[1]) > fabsf(d[major])) major = 1;
+        if (fabsf(d[2]) > fabsf(d[major])) major = 2;
+        int normal[3] = { 0, 0, 0 };
+        normal[major] = -step[major];
+        result.hit = true;
+        result.x = cell[0]; result.y = cell[1]; result.z = cell[2];
+        result.normalX = normal[0]; result.normalY = normal[1]; result.normalZ = normal[2];
+        return result;
+    }
+
+    while (true) {
+        int axis = 0;
+        if (tMax[1] < tMax[axis]) axis = 1;
+        if (tMax[2] < tMax[axis]) axis = 2;
+
+        float t = tMax[axis];
+        if (t > maxDistance) return result;
+
+        cell[axis] += step[axis];
+        tMax[axis] += tDelta[axis];
+        blocks.Move(axis, step[axis]);
+
+        // nothing but air above and below the world
+        if ((cell[1] < 0 && step[1] <= 0) || (cell[1] >= CHUNK_SIZE && step[1] >= 0)) return result;
+
+        if (IsSolid(blocks.Current())) {
+            result.hit = true;
+            result.x = cell[0]; result.y = cell[1]; result.z = cell[2];
+            result.normalX = axis == 0 ? -step[0] : 0;
+            result.normalY = axis == 1 ? -step[1] : 0;
+            result.normalZ = axis == 2 ? -step[2] : 0;
+            result.distance = t;
+            return result;
+        }
+    }
+}
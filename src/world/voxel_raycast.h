@@ -0,0 +1,30 @@
+#ifndef VOXEL_RAYCAST_H
+#define VOXEL_RAYCAST_H
+
+#include "raylib.h"
+
+class ChunkManager;
+
+// default player reach in blocks
+#define DEFAULT_REACH_DISTANCE 8.0f
+
+/**
+ * first solid block along a ray
+ * normal is the face the ray entered through (points back at the origin)
+ */
+struct VoxelHit {
+    bool hit = false;
+    int x = 0, y = 0, z = 0;
+    int normalX = 0, normalY = 0, normalZ = 0;
+    float distance = 0.0f;
+};
+
+/**
+ * walks the grid cells the ray passes through in order (amanatides & woo)
+ * and stops at the first solid block within maxDistance.
+ * unloaded chunks read as air and are never generated.
+ * a ray starting inside a solid block hits it at distance 0.
+ */
+VoxelHit RaycastBlocks(ChunkManager& world, Vector3 origin, Vector3 direction, float maxDistance);
+
+#endif
@@ -2,20 +2,61 @@
 #include "chunk_manager.h" 
 #include "raymath.h"
 #include <cstdlib>
+#include <cstring>
+#include <vector>
 #include "../blocks/block_types.h"
 
 int WorldGenerator::worldSeed = 0;
+int WorldGenerator::terrainVersion = TERRAIN_VERSION;
 
 // --- noise helpers ---
 
 float Fract(float x) { return x - floorf(x); }
 
 float Hash3D(int x, int y, int z) {
-	int h = x * 374761393 + y * 668265263 + z * 924083321;
-	h = (h ^ (h >> 13)) * 1274126177;
+	// unsigned math so the multiplies wrap instead of overflowing
+	int h = (int)((unsigned)x * 374761393u + (unsigned)y * 668265263u + (unsigned)z * 924083321u);
+	h = (int)((unsigned)(h ^ (h >> 13)) * 1274126177u);
 	return (h & 0xFFFF) / 65535.0f;
 }
 
+// widest structure footprint around its root column (tree canopies)
+static const int STRUCTURE_RADIUS = 2;
+
+// caves stay this far below sea level next to a lake, so none opens into one
+static const int LAKE_SEAL = 6;
+
+struct StructureRoot {
+	int x, y, z; // chunk-local, may lie outside the chunk
+	BiomeType biome;
+	float roll;
+};
+
+static bool InChunk(int x, int y, int z) {
+	return x >= 0 && x < CHUNK_SIZE && y >= 0 && y < CHUNK_SIZE && z >= 0 && z < CHUNK_SIZE;
+}
+
+/**
+ * writes a structure block if it lands inside the chunk and keeps the heightmap current
+ * overwrite=false only fills air (leaves)
+ */
+static void Stamp(Chunk& chunk, int x, int y, int z, BlockType type, bool overwrite) {
+	if (!InChunk(x, y, z)) return;
+	if (!overwrite && chunk.blocks[x][y][z] != BlockType::AIR) return;
+
+	chunk.blocks[x][y][z] = type;
+	if (y > chunk.heightMap[x][z]) chunk.heightMap[x][z] = (unsigned char)y;
+	if (BlocksSunlight(type) && y >= chunk.sunHeight[x][z]) chunk.sunHeight[x][z] = (unsigned char)(y + 1);
+}
+
+/**
+ * seeded per-column random value in [0, 1]
+ * replaces GetRandomValue so any chunk can re-derive its neighbours' features
+ */
+float WorldGenerator::ColumnRandom(int x, int z, int salt) {
+	return Hash3D(x + worldSeed, 1000 + salt * 7919, z - worldSeed);
+}
+
 /**
  * 3d simplex-like noise function for caves and organic shapes
  */
@@ -60,8 +101,10 @@ float WorldGenerator::GetHeightNoise(int x, int z) {
 	// TERRAIN SHAPING LOGIC
 	if (roughness < 0.5f) {
 		// LAINS (50% of world)
-		// Very flat, minor bumps (+/- 2 blocks)
-		finalHeight = SEA_LEVEL + (detail * 4.0f);
+		// Very flat, minor bumps (+/- 3 blocks), the lowest dips hold lakes
+		// (worlds from before lakes keep the old band, never below sea level)
+		if (terrainVersion < 2) finalHeight = SEA_LEVEL + (detail * 4.0f);
+		else finalHeight = SEA_LEVEL - 2.0f + (detail * 6.0f);
 	}
 	else {
 		// MOUNTAINS (50% of world)
@@ -74,6 +117,76 @@ float WorldGenerator::GetHeightNoise(int x, int z) {
 	return finalHeight;
 }
 
+/**
+ * terrain surface height for a column, clamped to the chunk
+ */
+int WorldGenerator::GetColumnHeight(int x, int z) {
+	int height = (int)GetHeightNoise(x, z);
+	if (height < 1) height = 1;
+	if (height >= CHUNK_SIZE) height = CHUNK_SIZE - 1;
+	return height;
+}
+
+/**
+ * caves only carve below this y in a column: lakes and their shores are sealed
+ */
+int WorldGenerator::GetCaveCeiling(int x, int z) {
+	bool nearLake = GetColumnHeight(x, z) < SEA_LEVEL ||
+		GetColumnHeight(x - 1, z) < SEA_LEVEL || GetColumnHeight(x + 1, z) < SEA_LEVEL ||
+		GetColumnHeight(x, z - 1) < SEA_LEVEL || GetColumnHeight(x, z + 1) < SEA_LEVEL;
+	return nearLake ? SEA_LEVEL - LAKE_SEAL : CHUNK_SIZE;
+}
+
+/**
+ * true if the cave noise carves out this block
+ */
+bool WorldGenerator::IsCave(int x, int y, int z) {
+	float caveNoise = SimpleNoise3D(x * 0.06f, y * 0.06f, z * 0.06f);
+
+	// DEPTH BIAS:
+	// At y=0 (Bedrock), Bias is 0.0. Threshold is 0.65 (Common caves)
+	// At y=64 (Sky), Bias is 1.0. Threshold is 1.15 (Impossible caves)
+	float depthBias = (float)y / (float)CHUNK_SIZE;
+	float threshold = 0.65f + (depthBias * 0.5f);
+
+	return caveNoise > threshold;
+}
+
+/**
+ * top block placed on a column of the given biome
+ */
+BlockType WorldGenerator::GetSurfaceBlock(BiomeType biome) {
+	switch (biome) {
+	case BiomeType::DESERT: return BlockType::SAND;
+	case BiomeType::SNOW:   return BlockType::SNOW;
+	default:                return BlockType::GRASS;
+	}
+}
+
+int WorldGenerator::GetSurfaceHeight(int x, int z) {
+	int height = GetColumnHeight(x, z);
+	return height < SEA_LEVEL ? SEA_LEVEL : height;
+}
+
+/**
+ * fills the per-column terrain height and biome maps for a chunk in one batch
+ */
+void WorldGenerator::GenerateColumns(int chunkX, int chunkZ, unsigned char heights[CHUNK_SIZE][CHUNK_SIZE], BiomeType biomes[CHUNK_SIZE][CHUNK_SIZE]) {
+	int offsetX = chunkX * CHUNK_SIZE;
+	int offsetZ = chunkZ * CHUNK_SIZE;
+
+	for (int x = 0; x < CHUNK_SIZE; x++) {
+		for (int z = 0; z < CHUNK_SIZE; z++) {
+			heights[x][z] = (unsigned char)GetColumnHeight(offsetX + x, offsetZ + z);
+		}
+	}
+	for (int x = 0; x < CHUNK_SIZE; x++) {
+		for (int z = 0; z < CHUNK_SIZE; z++) {
+			biomes[x][z] = GetBiome(offsetX + x, offsetZ + z);
+		}
+	}
+}
+
 // --- biome logic ---
 
 /**
@@ -93,23 +206,36 @@ BiomeType WorldGenerator::GetBiome(int x, int z) {
 /**
  * main generation function: populates a chunk with blocks
  * pass 1: terrain & caves
- * pass 2: decorations (trees, cacti)
+ * pass 2: structures (trees, cacti), including ones rooted in neighbours
  */
 void WorldGenerator::GenerateChunk(Chunk& chunk, int chunkX, int chunkZ) {
 	int offsetX = chunkX * CHUNK_SIZE;
 	int offsetZ = chunkZ * CHUNK_SIZE;
 
+	// column data is computed once and kept on the chunk
+	GenerateColumns(chunkX, chunkZ, chunk.heightMap, chunk.biomeMap);
+
+	// the heightmap is overwritten column by column below, keep the noise
+	// heights for the lake checks (same rule as GetCaveCeiling)
+	unsigned char heights[CHUNK_SIZE][CHUNK_SIZE];
+	memcpy(heights, chunk.heightMap, sizeof(heights));
+	auto isLake = [&](int x, int z) {
+		if (x >= 0 && x < CHUNK_SIZE && z >= 0 && z < CHUNK_SIZE) return heights[x][z] < SEA_LEVEL;
+		return GetColumnHeight(offsetX + x, offsetZ + z) < SEA_LEVEL;
+	};
+
 	// PASS 1: TERRAIN & CAVES
 	for (int x = 0; x < CHUNK_SIZE; x++) {
 		for (int z = 0; z < CHUNK_SIZE; z++) {
 			int worldX = offsetX + x;
 			int worldZ = offsetZ + z;
 
-			BiomeType biome = GetBiome(worldX, worldZ);
-			int height = (int)GetHeightNoise(worldX, worldZ);
+			BiomeType biome = chunk.biomeMap[x][z];
+			int height = chunk.heightMap[x][z];
+			int top = 0;
 
-			if (height < 1) height = 1;
-			if (height >= CHUNK_SIZE) height = CHUNK_SIZE - 1;
+			bool nearLake = isLake(x, z) || isLake(x - 1, z) || isLake(x + 1, z) || isLake(x, z - 1) || isLake(x, z + 1);
+			int caveCeiling = nearLake ? SEA_LEVEL - LAKE_SEAL : CHUNK_SIZE;
 
 			for (int y = 0; y < CHUNK_SIZE; y++) {
 				BlockType blockType = BlockType::AIR;
@@ -121,84 +247,110 @@ void WorldGenerator::GenerateChunk(Chunk& chunk, int chunkX, int chunkZ) {
 					else blockType = BlockType::DIRT;
 				}
 				else if (y == height) {
-					switch (biome) {
-					case BiomeType::DESERT: blockType = BlockType::SAND; break;
-					case BiomeType::SNOW:   blockType = BlockType::SNOW; break;
-					default:           blockType = BlockType::GRASS; break;
-					}
+					// nothing grows under water
+					if (height < SEA_LEVEL) blockType = biome == BiomeType::DESERT ? BlockType::SAND : BlockType::DIRT;
+					else blockType = GetSurfaceBlock(biome);
 				}
 
 				// CAVE GENERATION
-				if (blockType != BlockType::AIR && blockType != BlockType::BEDROCK && y > 3) {
-					float caveNoise = SimpleNoise3D(worldX * 0.06f, y * 0.06f, worldZ * 0.06f);
-
-					// DEPTH BIAS:
-					// At y=0 (Bedrock), Bias is 0.0. Threshold is 0.65 (Common caves)
-					// At y=64 (Sky), Bias is 1.0. Threshold is 1.15 (Impossible caves)
-					float depthBias = (float)y / (float)CHUNK_SIZE;
-					float threshold = 0.65f + (depthBias * 0.5f);
-
-					if (caveNoise > threshold) blockType = BlockType::AIR;
+				if (blockType != BlockType::AIR && blockType != BlockType::BEDROCK && y > 3 && y < caveCeiling) {
+					if (IsCave(worldX, y, worldZ)) blockType = BlockType::AIR;
 				}
 
 				chunk.blocks[x][y][z] = blockType;
+				if (blockType != BlockType::AIR) top = y;
+			}
+
+			// basins below sea level fill with still water
+			if (height < SEA_LEVEL) {
+				for (int y = top + 1; y <= SEA_LEVEL; y++) chunk.blocks[x][y][z] = BlockType::WATER;
+				top = SEA_LEVEL;
 			}
+
+			// caves can carve the surface, so store the real top
+			// (terrain blocks are all opaque and water stops direct sun, so it stops right above it)
+			chunk.heightMap[x][z] = (unsigned char)top;
+			chunk.sunHeight[x][z] = (unsigned char)(top + 1);
 		}
 	}
 
-	// PASS 2: DECORATION
-	for (int x = 0; x < CHUNK_SIZE; x++) {
-		for (int z = 0; z < CHUNK_SIZE; z++) {
+	// PASS 2: STRUCTURES
+	PlaceStructures(chunk, chunkX, chunkZ);
+}
 
-			int worldX = offsetX + x;
-			int worldZ = offsetZ + z;
+/**
+ * deterministic structure pass
+ * every column within STRUCTURE_RADIUS of the chunk decides on its own whether
+ * it roots a structure, so neighbouring chunks agree on the same trees and each
+ * one stamps in only the blocks that land inside it
+ */
+void WorldGenerator::PlaceStructures(Chunk& chunk, int chunkX, int chunkZ) {
+	int offsetX = chunkX * CHUNK_SIZE;
+	int offsetZ = chunkZ * CHUNK_SIZE;
 
-			// find Top Block
-			int height = -1;
-			for (int y = CHUNK_SIZE - 1; y >= 0; y--) {
-				if (chunk.blocks[x][y][z] != BlockType::AIR) {
-					height = y;
-					break;
-				}
+	// decide every root before stamping, so leaves can't change the answer
+	std::vector<StructureRoot> roots;
+
+	// iterate in world order so overlapping trees resolve the same way in every chunk
+	for (int worldX = offsetX - STRUCTURE_RADIUS; worldX < offsetX + CHUNK_SIZE + STRUCTURE_RADIUS; worldX++) {
+		for (int worldZ = offsetZ - STRUCTURE_RADIUS; worldZ < offsetZ + CHUNK_SIZE + STRUCTURE_RADIUS; worldZ++) {
+
+			// cheap rejection first (same 2% density as before)
+			if (ColumnRandom(worldX, worldZ, 0) >= 0.02f) continue;
+
+			int x = worldX - offsetX;
+			int z = worldZ - offsetZ;
+			int height;
+			BiomeType biome;
+
+			if (x >= 0 && x < CHUNK_SIZE && z >= 0 && z < CHUNK_SIZE) {
+				// own column: read the cached maps, the top must be the biome's surface block
+				// (flooded columns end in water)
+				height = chunk.heightMap[x][z];
+				biome = chunk.biomeMap[x][z];
+				if (chunk.blocks[x][height][z] != GetSurfaceBlock(biome)) continue;
+			}
+			else {
+				// neighbour column: re-derive it from noise
+				height = GetColumnHeight(worldX, worldZ);
+				biome = GetBiome(worldX, worldZ);
+
+				// nothing grows under water, and a cave breaking the surface leaves nothing to grow on
+				if (height < SEA_LEVEL) continue;
+				if (height < GetCaveCeiling(worldX, worldZ) && IsCave(worldX, height, worldZ)) continue;
 			}
 
 			if (height <= 0 || height >= CHUNK_SIZE - 8) continue;
 
-			BlockType topBlock = chunk.blocks[x][height][z];
-
-			if (x > 2 && x < CHUNK_SIZE - 3 && z > 2 && z < CHUNK_SIZE - 3) {
-				BiomeType biome = GetBiome(worldX, worldZ);
-
-				if (GetRandomValue(0, 100) < 2) {
-					if (biome == BiomeType::DESERT && topBlock == BlockType::SAND) {
-						PlaceCactus(chunk, x, height + 1, z);
-					}
-					else if (biome == BiomeType::FOREST && topBlock == BlockType::GRASS) {
-						PlaceTree(chunk, x, height + 1, z, BiomeType::FOREST);
-					}
-					else if (biome == BiomeType::SNOW && topBlock == BlockType::SNOW) {
-						// exclusive snow tree
-						PlaceSnowTree(chunk, x, height + 1, z);
-					}
-				}
-			}
+			roots.push_back({ x, height + 1, z, biome, ColumnRandom(worldX, worldZ, 1) });
+		}
+	}
+
+	for (const StructureRoot& root : roots) {
+		switch (root.biome) {
+		case BiomeType::DESERT: PlaceCactus(chunk, root.x, root.y, root.z, root.roll); break;
+		case BiomeType::SNOW:   PlaceSnowTree(chunk, root.x, root.y, root.z, root.roll); break; // exclusive snow tree
+		default:                PlaceTree(chunk, root.x, root.y, root.z, root.roll); break;
 		}
 	}
 }
 
-void WorldGenerator::PlaceCactus(Chunk& chunk, int x, int y, int z) {
-	int height = GetRandomValue(2, 4);
+void WorldGenerator::PlaceCactus(Chunk& chunk, int x, int y, int z, float roll) {
+	int height = 2 + (int)(roll * 2.99f); // 2 - 4
 	for (int i = 0; i < height; i++) {
-		if (y + i < CHUNK_SIZE) chunk.blocks[x][y + i][z] = BlockType::CACTUS;
+		Stamp(chunk, x, y + i, z, BlockType::CACTUS, true);
 	}
 }
 
-void WorldGenerator::PlaceTree(Chunk& chunk, int x, int y, int z, BiomeType biome) {
-	int height = GetRandomValue(4, 6);
+void WorldGenerator::PlaceTree(Chunk& chunk, int x, int y, int z, float roll) {
+	int height = 4 + (int)(roll * 2.99f); // 4 - 6
+
+	// grass can't live under the trunk, dirt is what the grass tick would leave
+	Stamp(chunk, x, y - 1, z, BlockType::DIRT, true);
 
 	// trunk
 	for (int i = 0; i < height; i++) {
-		if (y + i < CHUNK_SIZE) chunk.blocks[x][y + i][z] = BlockType::WOOD;
+		Stamp(chunk, x, y + i, z, BlockType::WOOD, true);
 	}
 
 	// leaves
@@ -215,22 +367,21 @@ void WorldGenerator::PlaceTree(Chunk& chunk, int x, int y, int z, BiomeType biom
 				int fy = y + ly;
 				int fz = z + lz;
 
-				if (fx >= 0 && fx < CHUNK_SIZE && fy >= 0 && fy < CHUNK_SIZE && fz >= 0 && fz < CHUNK_SIZE) {
-					if (chunk.blocks[fx][fy][fz] == BlockType::AIR) {
-						chunk.blocks[fx][fy][fz] = BlockType::LEAVES;
-					}
-				}
+				Stamp(chunk, fx, fy, fz, BlockType::LEAVES, false);
 			}
 		}
 	}
 }
 
-void WorldGenerator::PlaceSnowTree(Chunk& chunk, int x, int y, int z) {
-	int height = GetRandomValue(6, 8); // taller than oak
+void WorldGenerator::PlaceSnowTree(Chunk& chunk, int x, int y, int z, float roll) {
+	int height = 6 + (int)(roll * 2.99f); // taller than oak
+
+	// grass can't live under the trunk, dirt is what the grass tick would leave
+	Stamp(chunk, x, y - 1, z, BlockType::DIRT, true);
 
 	// trunk
 	for (int i = 0; i < height; i++) {
-		if (y + i < CHUNK_SIZE) chunk.blocks[x][y + i][z] = BlockType::WOOD;
+		Stamp(chunk, x, y + i, z, BlockType::WOOD, true);
 	}
 
 	// conical leaves
@@ -254,11 +405,7 @@ void WorldGenerator::PlaceSnowTree(Chunk& chunk, int x, int y, int z) {
 				int fy = y + i;
 				int fz = z + lz;
 
-				if (fx >= 0 && fx < CHUNK_SIZE && fy >= 0 && fy < CHUNK_SIZE && fz >= 0 && fz < CHUNK_SIZE) {
-					if (chunk.blocks[fx][fy][fz] == BlockType::AIR) {
-						chunk.blocks[fx][fy][fz] = BlockType::SNOW_LEAVES;
-					}
-				}
+				Stamp(chunk, fx, fy, fz, BlockType::SNOW_LEAVES, false);
 			}
 		}
 	}
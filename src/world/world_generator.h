@@ -17,17 +17,43 @@ public:
      * generating terrain data for a single chunk (blocks only)
      */
     static void GenerateChunk(Chunk& chunk, int chunkX, int chunkZ);
+
+    /**
+     * terrain height and biome for every column of a chunk (no blocks)
+     */
+    static void GenerateColumns(int chunkX, int chunkZ, unsigned char heights[CHUNK_SIZE][CHUNK_SIZE], BiomeType biomes[CHUNK_SIZE][CHUNK_SIZE]);
+
+    /**
+     * terrain surface y for a world column, straight from the noise
+     * (the water surface over basins)
+     * ignores caves and structures (good enough for spawn points)
+     */
+    static int GetSurfaceHeight(int x, int z);
+
+    /**
+     * terrain height for a world column before lakes fill in (below
+     * SEA_LEVEL means the column is under water)
+     */
+    static int GetColumnHeight(int x, int z);
+    static BiomeType GetBiome(int x, int z);
+    static BlockType GetSurfaceBlock(BiomeType biome);
+
     static int worldSeed;
+    static int terrainVersion; // TERRAIN_VERSION unless the world is older
 
 private:
-    static BiomeType GetBiome(int x, int z);
-    static void PlaceTree(Chunk& chunk, int x, int y, int z, BiomeType biome);
-    static void PlaceCactus(Chunk& chunk, int x, int y, int z);
+    // structures (local coords may lie outside the chunk, blocks are clipped)
+    static void PlaceStructures(Chunk& chunk, int chunkX, int chunkZ);
+    static void PlaceTree(Chunk& chunk, int x, int y, int z, float roll);
+    static void PlaceCactus(Chunk& chunk, int x, int y, int z, float roll);
+    static void PlaceSnowTree(Chunk& chunk, int x, int y, int z, float roll);
     
     // noise helpers
     static float SimpleNoise3D(float x, float y, float z);
-    static void PlaceSnowTree(Chunk& chunk, int x, int y, int z);
     static float GetHeightNoise(int x, int z);
+    static bool IsCave(int x, int y, int z);
+    static int GetCaveCeiling(int x, int z);
+    static float ColumnRandom(int x, int z, int salt);
 };
 
 #endif
\ No newline at end of file
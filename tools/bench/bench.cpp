@@ -0,0 +1,861 @@
+#include "world/chunk_manager.h"
+#include "world/world_generator.h"
+#include "world/voxel_raycast.h"
+#include "world/block_accessor.h"
+#include "world/edit_tools.h"
+#include "world/far_terrain.h"
+#include "core/headless_runner.h"
+#include "core/input.h"
+#include "core/job_system.h"
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <memory>
+
+// the world code reads these globals (normally defined by main.cpp)
+int RENDER_DISTANCE = 4;
+int CHUNK_MEMORY_MB = 512;
+
+/**
+ * headless benchmark for the world hot paths
+ * never opens a window, only the cpu side of the engine is exercised
+ *
+ * usage: vsandbox_bench [--seed N] [--radius R] [--iterations N] [--replay file.rpl] [--out file.json]
+ *                       [--verify-raycast]
+ *
+ * without --replay the flight pass uses a scripted fly-through of the seed
+ * --verify-raycast only checks the grid raycast against a brute-force search
+ */
+
+struct BenchOptions {
+    int seed = 12345;
+    int radius = 2;          // world is (2r+1)^2 chunks
+    int iterations = 3;      // repeats for the per-chunk passes
+    const char* outPath = nullptr;
+    const char* replayPath = nullptr;
+    bool verifyRaycast = false;
+};
+
+/**
+ * timing samples for one benchmark, reported in milliseconds
+ */
+struct BenchResult {
+    std::string name;
+    std::string unit;        // what one sample measures
+    std::vector<double> samples;
+    double work = 0.0;       // optional throughput figure (vertices, bytes...)
+    std::string workUnit;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static double ElapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static double Mean(const std::vector<double>& v) {
+    double sum = 0.0;
+    for (double x : v) sum += x;
+    return v.empty() ? 0.0 : sum / v.size();
+}
+
+static double Percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t index = (size_t)(p * (v.size() - 1) + 0.5);
+    return v[index];
+}
+
+/**
+ * fixed chunk coordinate list, same order on every run
+ */
+static std::vector<ChunkCoord> WorldCoords(int radius) {
+    std::vector<ChunkCoord> coords;
+    for (int cx = -radius; cx <= radius; cx++) {
+        for (int cz = -radius; cz <= radius; cz++) {
+            coords.push_back({ cx, cz });
+        }
+    }
+    return coords;
+}
+
+static BenchResult BenchGenerate(const BenchOptions& opt) {
+    BenchResult result = { "generate_chunk", "ms/chunk" };
+    std::unique_ptr<Chunk> scratch = std::make_unique<Chunk>();
+
+    for (int it = 0; it < opt.iterations; it++) {
+        for (const ChunkCoord& c : WorldCoords(opt.radius)) {
+            Clock::time_point start = Clock::now();
+            WorldGenerator::GenerateChunk(*scratch, c.x, c.z);
+            result.samples.push_back(ElapsedMs(start));
+        }
+    }
+    return result;
+}
+
+/**
+ * the loading screen's path: a whole world generated, lit and hooked up
+ * as one job system batch
+ */
+static BenchResult BenchPreload(const BenchOptions& opt) {
+    BenchResult result = { "preload_batch", "ms/chunk" };
+    std::vector<ChunkCoord> coords = WorldCoords(opt.radius);
+
+    for (int it = 0; it < opt.iterations; it++) {
+        ChunkManager world;
+        world.Init();
+        Clock::time_point start = Clock::now();
+        world.GenerateBatch(coords);
+        result.samples.push_back(ElapsedMs(start) / coords.size());
+        world.UnloadAll();
+    }
+    result.work = (double)(JobSystem::GetWorkerCount() + 1);
+    result.workUnit = "threads";
+    return result;
+}
+
+static BenchResult BenchLighting(const BenchOptions& opt, ChunkManager& world) {
+    BenchResult result = { "compute_lighting", "ms/chunk" };
+
+    for (int it = 0; it < opt.iterations; it++) {
+        for (const ChunkCoord& c : WorldCoords(opt.radius)) {
+            Chunk* chunk = world.FindChunk(c.x, c.z);
+            Clock::time_point start = Clock::now();
+            world.ComputeChunkLighting(*chunk);
+            result.samples.push_back(ElapsedMs(start));
+        }
+    }
+    return result;
+}
+
+static BenchResult BenchMeshing(const BenchOptions& opt, ChunkManager& world) {
+    BenchResult result = { "build_mesh_cpu", "ms/chunk" };
+    MeshBuffers buffers;
+    size_t vertices = 0;
+
+    // interior chunks only, so every mesh sees all of its neighbours
+    for (int it = 0; it < opt.iterations; it++) {
+        for (const ChunkCoord& c : WorldCoords(opt.radius - 1)) {
+            Clock::time_point start = Clock::now();
+            world.BuildMeshData(c.x, c.z, buffers);
+            result.samples.push_back(ElapsedMs(start));
+            if (it == 0) vertices += buffers.VertexCount();
+        }
+    }
+    result.work = (double)vertices;
+    result.workUnit = "vertices";
+    return result;
+}
+
+static void BenchSerialization(const BenchOptions& opt, ChunkManager& world, std::vector<BenchResult>& results) {
+    BenchResult save = { "save_chunks", "ms/world" };
+    BenchResult load = { "load_chunks", "ms/world" };
+    const char* path = "vsandbox_bench.tmp";
+    long long bytes = 0;
+
+    for (int it = 0; it < opt.iterations; it++) {
+        Clock::time_point start = Clock::now();
+        {
+            std::ofstream out(path, std::ios::binary);
+            world.SaveChunks(out);
+            bytes = (long long)out.tellp();
+        }
+        save.samples.push_back(ElapsedMs(start));
+
+        start = Clock::now();
+        {
+            std::ifstream in(path, std::ios::binary);
+            world.LoadChunks(in);
+        }
+        load.samples.push_back(ElapsedMs(start));
+    }
+    std::remove(path);
+
+    save.work = (double)bytes;
+    save.workUnit = "bytes";
+    load.work = (double)bytes;
+    load.workUnit = "bytes";
+    results.push_back(save);
+    results.push_back(load);
+}
+
+static BenchResult BenchGetBlock(const BenchOptions& opt, ChunkManager& world) {
+    BenchResult result = { "get_block", "ns/lookup" };
+    const int lookups = 1000000;
+    int span = (opt.radius * 2 + 1) * CHUNK_SIZE;
+    int origin = -opt.radius * CHUNK_SIZE;
+
+    // xorshift keeps the access pattern identical between runs
+    unsigned int state = (unsigned int)opt.seed | 1u;
+    std::vector<int> coords(lookups * 3);
+    for (int i = 0; i < lookups; i++) {
+        state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+        coords[i * 3 + 0] = origin + (int)(state % span);
+        coords[i * 3 + 1] = (int)((state >> 8) % CHUNK_SIZE);
+        coords[i * 3 + 2] = origin + (int)((state >> 4) % span);
+    }
+
+    for (int it = 0; it < opt.iterations; it++) {
+        int solid = 0;
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < lookups; i++) {
+            if (world.GetBlock(coords[i * 3], coords[i * 3 + 1], coords[i * 3 + 2], false) != BlockType::AIR) solid++;
+        }
+        double ms = ElapsedMs(start);
+        result.samples.push_back(ms * 1e6 / lookups);
+        result.work = (double)solid; // keeps the loop from being optimized out
+    }
+    result.workUnit = "solid hits";
+    return result;
+}
+
+/**
+ * reading a padded 18^3 box (a 16^3 section plus one block of neighbours)
+ * block by block through GetBlock, against one CopyRegion
+ */
+static void BenchRegion(const BenchOptions& opt, ChunkManager& world, std::vector<BenchResult>& results) {
+    BenchResult single = { "region_get_block", "ns/block" };
+    BenchResult copy = { "region_copy", "ns/block" };
+    const int size = 18;
+    const int boxes = 200;
+    std::vector<BlockType> region;
+
+    // boxes straddle chunk borders on purpose
+    int span = (opt.radius * 2 + 1) * CHUNK_SIZE - size;
+    int origin = -opt.radius * CHUNK_SIZE;
+    unsigned int state = (unsigned int)opt.seed | 1u;
+    std::vector<int> corners(boxes * 3);
+    for (int i = 0; i < boxes; i++) {
+        state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+        corners[i * 3 + 0] = origin + (int)(state % span);
+        corners[i * 3 + 1] = (int)((state >> 8) % (CHUNK_SIZE - size));
+        corners[i * 3 + 2] = origin + (int)((state >> 4) % span);
+    }
+    double blocks = (double)boxes * size * size * size;
+
+    for (int it = 0; it < opt.iterations; it++) {
+        int solid = 0;
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < boxes; i++) {
+            int bx = corners[i * 3], by = corners[i * 3 + 1], bz = corners[i * 3 + 2];
+            for (int x = bx; x < bx + size; x++) {
+                for (int y = by; y < by + size; y++) {
+                    for (int z = bz; z < bz + size; z++) {
+                        if (world.GetBlock(x, y, z, false) != BlockType::AIR) solid++;
+                    }
+                }
+            }
+        }
+        single.samples.push_back(ElapsedMs(start) * 1e6 / blocks);
+        single.work = solid;
+
+        solid = 0;
+        start = Clock::now();
+        BlockAccessor accessor(world);
+        for (int i = 0; i < boxes; i++) {
+            int bx = corners[i * 3], by = corners[i * 3 + 1], bz = corners[i * 3 + 2];
+            accessor.CopyRegion(bx, by, bz, bx + size - 1, by + size - 1, bz + size - 1, region);
+            for (BlockType type : region) {
+                if (type != BlockType::AIR) solid++;
+            }
+        }
+        copy.samples.push_back(ElapsedMs(start) * 1e6 / blocks);
+        copy.work = solid;
+    }
+    single.workUnit = "solid blocks";
+    copy.workUnit = "solid blocks";
+    results.push_back(single);
+    results.push_back(copy);
+}
+
+/**
+ * random rays starting in air somewhere in the resident world
+ */
+static void MakeRays(const BenchOptions& opt, ChunkManager& world, int count, std::vector<Vector3>& origins, std::vector<Vector3>& directions) {
+    float span = (float)((opt.radius * 2 + 1) * CHUNK_SIZE);
+    float origin = (float)(-opt.radius * CHUNK_SIZE);
+    unsigned int state = (unsigned int)opt.seed | 1u;
+    auto next = [&]() {
+        state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+        return (state & 0xFFFFFF) / (float)0x1000000;
+    };
+
+    while ((int)origins.size() < count) {
+        Vector3 o = { origin + next() * span, next() * CHUNK_SIZE, origin + next() * span };
+        Vector3 d = { next() * 2.0f - 1.0f, next() * 2.0f - 1.0f, next() * 2.0f - 1.0f };
+        float length = sqrtf(d.x * d.x + d.y * d.y + d.z * d.z);
+        if (length < 0.1f || length > 1.0f) continue; // uniform over the sphere
+        if (IsSolid(world.GetBlock((int)floorf(o.x), (int)floorf(o.y), (int)floorf(o.z), false))) continue;
+        origins.push_back(o);
+        directions.push_back({ d.x / length, d.y / length, d.z / length });
+    }
+}
+
+/**
+ * the box search Player::UpdateRaycast used before the grid walk:
+ * every solid block within `radius` of the origin is tested against the ray
+ */
+static VoxelHit BruteForceRaycast(ChunkManager& world, Vector3 origin, Vector3 direction, float maxDistance, int radius) {
+    VoxelHit result;
+    Ray ray = { origin, direction };
+    float closest = maxDistance;
+    int ox = (int)floorf(origin.x), oy = (int)floorf(origin.y), oz = (int)floorf(origin.z);
+
+    for (int x = ox - radius; x <= ox + radius; x++) {
+        for (int y = oy - radius; y <= oy + radius; y++) {
+            for (int z = oz - radius; z <= oz + radius; z++) {
+                if (!IsSolid(world.GetBlock(x, y, z, false))) continue;
+
+                BoundingBox box = { { (float)x, (float)y, (float)z }, { x + 1.0f, y + 1.0f, z + 1.0f } };
+                RayCollision collision = GetRayCollisionBox(ray, box);
+                // raylib reports boxes touching the origin from behind with a negative distance
+                if (collision.hit && collision.distance >= 0.0f && collision.distance < closest) {
+                    closest = collision.distance;
+                    result.hit = true;
+                    result.x = x; result.y = y; result.z = z;
+                    result.normalX = (int)roundf(collision.normal.x);
+                    result.normalY = (int)roundf(collision.normal.y);
+                    result.normalZ = (int)roundf(collision.normal.z);
+                    result.distance = collision.distance;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * block selection cost per ray: the grid walk against the old 13^3 box search
+ */
+static void BenchRaycast(const BenchOptions& opt, ChunkManager& world, std::vector<BenchResult>& results) {
+    BenchResult grid = { "raycast_grid", "us/ray" };
+    BenchResult brute = { "raycast_box_search", "us/ray" };
+    const int rays = 10000;
+    std::vector<Vector3> origins, directions;
+    MakeRays(opt, world, rays, origins, directions);
+
+    for (int it = 0; it < opt.iterations; it++) {
+        int hits = 0;
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < rays; i++) {
+            if (RaycastBlocks(world, origins[i], directions[i], DEFAULT_REACH_DISTANCE).hit) hits++;
+        }
+        grid.samples.push_back(ElapsedMs(start) * 1000.0 / rays);
+        grid.work = hits;
+
+        hits = 0;
+        start = Clock::now();
+        for (int i = 0; i < rays; i++) {
+            if (BruteForceRaycast(world, origins[i], directions[i], DEFAULT_REACH_DISTANCE, 6).hit) hits++;
+        }
+        brute.samples.push_back(ElapsedMs(start) * 1000.0 / rays);
+        brute.work = hits;
+    }
+    grid.workUnit = "hits";
+    brute.workUnit = "hits";
+    results.push_back(grid);
+    results.push_back(brute);
+}
+
+/**
+ * checks the grid walk against a box search wide enough to cover the whole
+ * reach. rays that graze an edge or corner can hit two blocks at the same
+ * distance, those count as ties rather than mismatches. raylib also returns a
+ * diagonal normal for hits within ~0.005 of a box edge, those are counted as
+ * edge normals when the grid normal is one of its axes
+ */
+static bool VerifyRaycast(const BenchOptions& opt, ChunkManager& world) {
+    const int rays = 100000;
+    const float reach = DEFAULT_REACH_DISTANCE;
+    int radius = (int)ceilf(reach) + 1;
+    std::vector<Vector3> origins, directions;
+    MakeRays(opt, world, rays, origins, directions);
+
+    int hits = 0, ties = 0, edgeNormals = 0, mismatches = 0;
+    for (int i = 0; i < rays; i++) {
+        VoxelHit a = RaycastBlocks(world, origins[i], directions[i], reach);
+        VoxelHit b = BruteForceRaycast(world, origins[i], directions[i], reach, radius);
+        if (a.hit) hits++;
+
+        bool same = a.hit == b.hit;
+        if (same && a.hit) {
+            same = a.x == b.x && a.y == b.y && a.z == b.z &&
+                a.normalX == b.normalX && a.normalY == b.normalY && a.normalZ == b.normalZ &&
+                fabsf(a.distance - b.distance) < 1e-3f;
+        }
+        if (same) continue;
+
+        // same distance, or a hit right at the end of reach that one side rounds away
+        bool tie = (a.hit && b.hit) ? fabsf(a.distance - b.distance) < 1e-3f
+            : fabsf((a.hit ? a.distance : b.distance) - reach) < 1e-3f;
+        if (tie) {
+            bool sameCell = a.hit && b.hit && a.x == b.x && a.y == b.y && a.z == b.z;
+            int boxAxes = abs(b.normalX) + abs(b.normalY) + abs(b.normalZ);
+            bool gridAxisInBox = (a.normalX == 0 || a.normalX == b.normalX) &&
+                (a.normalY == 0 || a.normalY == b.normalY) && (a.normalZ == 0 || a.normalZ == b.normalZ);
+            if (sameCell && boxAxes > 1 && gridAxisInBox) edgeNormals++;
+            else ties++;
+            continue;
+        }
+
+        if (mismatches < 10) {
+            fprintf(stderr, "  mismatch: ray (%.4f %.4f %.4f) -> (%.4f %.4f %.4f): grid %d (%d %d %d) n(%d %d %d) %.4f, box %d (%d %d %d) n(%d %d %d) %.4f\n",
+                origins[i].x, origins[i].y, origins[i].z, directions[i].x, directions[i].y, directions[i].z,
+                a.hit, a.x, a.y, a.z, a.normalX, a.normalY, a.normalZ, a.distance,
+                b.hit, b.x, b.y, b.z, b.normalX, b.normalY, b.normalZ, b.distance);
+        }
+        mismatches++;
+    }
+
+    fprintf(stderr, "raycast: %d rays, %d hits, %d ties, %d edge normals, %d mismatches\n", rays, hits, ties, edgeNormals, mismatches);
+    return mismatches == 0;
+}
+
+/**
+ * steady-state tick cost with 500 resident chunks: settled falling-block
+ * physics (should not depend on how many chunks are loaded) and block ticks
+ * (bounded by the tick budget)
+ */
+static void BenchTicks(const BenchOptions& opt, std::vector<BenchResult>& results) {
+    BenchResult physics = { "physics_idle_tick", "ms/tick" };
+    BenchResult blockTicks = { "block_tick", "ms/tick" };
+    const int width = 25, depth = 20; // 500 chunks
+    const int ticks = 200;
+
+    ChunkManager world;
+    world.Init();
+    for (int cx = 0; cx < width; cx++) {
+        for (int cz = 0; cz < depth; cz++) world.GetOrCreateChunk(cx - width / 2, cz - depth / 2);
+    }
+
+    // let generated sand land first
+    for (int i = 0; i < CHUNK_SIZE && world.GetActivePhysicsChunks() > 0; i++) world.UpdateChunkPhysics();
+
+    for (int it = 0; it < opt.iterations; it++) {
+        for (int i = 0; i < ticks; i++) {
+            Clock::time_point start = Clock::now();
+            world.UpdateChunkPhysics();
+            physics.samples.push_back(ElapsedMs(start));
+
+            start = Clock::now();
+            world.UpdateBlockTicks();
+            blockTicks.samples.push_back(ElapsedMs(start));
+        }
+    }
+    physics.work = (double)world.GetChunkCount();
+    physics.workUnit = "resident chunks";
+    blockTicks.work = (double)world.GetTicks().budget;
+    blockTicks.workUnit = "budget";
+    world.UnloadAll();
+
+    results.push_back(physics);
+    results.push_back(blockTicks);
+}
+
+/**
+ * block edits: a 32^3 cube filled as one edit (straddling four chunks, so
+ * four relights), against single SetBlock calls that relight every time,
+ * and single edits followed by the remesh they cause (compare build_mesh_cpu),
+ * also timed without the edit's relight
+ */
+static void BenchEdits(const BenchOptions& opt, std::vector<BenchResult>& results) {
+    BenchResult fill = { "edit_fill_32", "ms/fill" };
+    BenchResult single = { "edit_single_block", "ms/edit" };
+    BenchResult remesh = { "edit_remesh", "ms/edit" };
+    BenchResult remeshOnly = { "edit_remesh_sections", "ms/edit" };
+    const int size = 32;
+    const int singles = 32;
+    const int x0 = CHUNK_SIZE - size / 2, y0 = 8, z0 = CHUNK_SIZE - size / 2;
+
+    ChunkManager world;
+    world.Init();
+    // one ring more than the edited 3x3, so all of those can be meshed
+    for (const ChunkCoord& c : WorldCoords(2)) world.GetOrCreateChunk(c.x + 1, c.z + 1);
+
+    for (int it = 0; it < opt.iterations * 2; it++) {
+        // alternate so every fill really changes the blocks
+        BlockType type = it % 2 == 0 ? BlockType::STONE : BlockType::AIR;
+        Clock::time_point start = Clock::now();
+        FillBox(world, x0, y0, z0, x0 + size - 1, y0 + size - 1, z0 + size - 1, type);
+        fill.samples.push_back(ElapsedMs(start));
+    }
+    fill.work = size * size * size;
+    fill.workUnit = "blocks";
+
+    for (int it = 0; it < opt.iterations; it++) {
+        for (int i = 0; i < singles; i++) {
+            Clock::time_point start = Clock::now();
+            world.SetBlock(x0 + i, y0 + size / 2, z0 + i, i % 2 == 0 ? BlockType::STONE : BlockType::AIR);
+            single.samples.push_back(ElapsedMs(start));
+        }
+    }
+
+    // mesh everything once, then every edit only pays for its dirty sections
+    std::vector<ChunkCoord> coords = WorldCoords(1);
+    for (const ChunkCoord& c : coords) world.RebuildMesh(c.x + 1, c.z + 1, nullptr);
+
+    int sections = 0;
+    for (int it = 0; it < opt.iterations; it++) {
+        for (int i = 0; i < singles; i++) {
+            Clock::time_point start = Clock::now();
+            world.SetBlock(x0 + i, y0 + size / 2, z0 + i, i % 2 == 0 ? BlockType::STONE : BlockType::AIR);
+            Clock::time_point meshStart = Clock::now();
+            for (const ChunkCoord& c : coords) {
+                Chunk* chunk = world.FindChunk(c.x + 1, c.z + 1);
+                for (uint64_t bits = chunk->dirtySections; bits; bits &= bits - 1) sections++;
+                world.RebuildMesh(c.x + 1, c.z + 1, nullptr);
+            }
+            remeshOnly.samples.push_back(ElapsedMs(meshStart));
+            remesh.samples.push_back(ElapsedMs(start));
+        }
+    }
+    remesh.work = sections;
+    remesh.workUnit = "sections remeshed";
+    remeshOnly.work = sections;
+    remeshOnly.workUnit = "sections remeshed";
+
+    world.UnloadAll();
+    results.push_back(fill);
+    results.push_back(single);
+    results.push_back(remesh);
+    results.push_back(remeshOnly);
+}
+
+/**
+ * water cells in a loaded chunk
+ */
+static int CountWater(const Chunk& chunk) {
+    int count = 0;
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            for (int y = 0; y <= chunk.heightMap[x][z]; y++) {
+                if (chunk.blocks[x][y][z] == BlockType::WATER) count++;
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * flood cost: a 48x48x16 pit is dug under a sheet of source water at sea
+ * level and the water pours in, one sample per water step until it settles
+ */
+static void BenchFlood(const BenchOptions& opt, std::vector<BenchResult>& results) {
+    BenchResult flood = { "fluid_flood", "ms/step" };
+    const int pit = 48;
+    const int pitDepth = 16;
+    const int maxSteps = 4000;
+
+    for (int it = 0; it < opt.iterations; it++) {
+        ChunkManager world;
+        world.Init();
+        for (const ChunkCoord& c : WorldCoords(1)) world.GetOrCreateChunk(c.x, c.z);
+
+        // whatever was flowing at generation (caves) settles first
+        for (int i = 0; i < maxSteps && world.GetActiveFluidChunks() > 0; i++) world.StepFluids();
+
+        Chunk* chunk = world.FindChunk(0, 0);
+        int start = (CHUNK_SIZE - pit) / 2;
+        for (int x = start; x < start + pit; x++) {
+            for (int z = start; z < start + pit; z++) {
+                for (int y = SEA_LEVEL - pitDepth; y < SEA_LEVEL; y++) chunk->blocks[x][y][z] = BlockType::AIR;
+                chunk->blocks[x][SEA_LEVEL][z] = BlockType::WATER;
+            }
+        }
+        chunk->fluidLevels.clear();
+        world.RefreshChunk(0, 0);
+
+        int steps = 0;
+        while (steps < maxSteps && world.GetActiveFluidChunks() > 0) {
+            Clock::time_point tickStart = Clock::now();
+            world.StepFluids();
+            flood.samples.push_back(ElapsedMs(tickStart));
+            steps++;
+        }
+        flood.work = steps;
+
+        if (it == 0) fprintf(stderr, "  flood settled after %d steps, %d water cells\n", steps, CountWater(*chunk));
+        world.UnloadAll();
+    }
+    flood.workUnit = "steps to settle";
+    results.push_back(flood);
+}
+
+/**
+ * writes a scripted flight: sprint-flying forward while slowly turning,
+ * so new chunks keep streaming in the whole time
+ */
+static bool WriteScriptedFlight(const char* path, int seed) {
+    InputRecorder recorder;
+    ReplayHeader header = {};
+    header.seed = seed;
+    header.position = { 16.0f, (float)CHUNK_SIZE, 16.0f };
+    header.isFlying = true;
+    if (!recorder.Start(path, header)) return false;
+
+    const int frames = 1200; // 20 seconds at REPLAY_TIMESTEP
+    for (int i = 0; i < frames; i++) {
+        InputFrame frame = {};
+        frame.mouseDX = 2.0f;
+        frame.held = INPUT_FORWARD | INPUT_SPRINT;
+        recorder.Record(frame);
+    }
+    recorder.Stop();
+    return true;
+}
+
+/**
+ * end-to-end pass: a replay run headless (generation, physics, lighting, cpu meshing)
+ */
+static void BenchFlight(const BenchOptions& opt, std::vector<BenchResult>& results) {
+    const char* path = opt.replayPath;
+    const char* scriptedPath = "vsandbox_bench_flight.tmp";
+    if (!path) {
+        if (!WriteScriptedFlight(scriptedPath, opt.seed)) return;
+        path = scriptedPath;
+    }
+
+    BenchResult frame = { "replay_frame", "ms/frame" };
+    BenchResult passes = { "replay_mesh_passes", "meshes/chunk" };
+    BenchResult rebuilds = { "replay_mesh_rebuilds", "rebuilds/chunk" };
+    BenchResult missed = { "replay_missed_chunks", "chunks/min" };
+    for (int it = 0; it < opt.iterations; it++) {
+        HeadlessResult run;
+        if (!RunHeadlessReplay(path, run)) {
+            fprintf(stderr, "could not read replay %s\n", path);
+            break;
+        }
+        frame.samples.insert(frame.samples.end(), run.frameMs.begin(), run.frameMs.end());
+        frame.work = (double)run.chunksLoaded;
+        // first mesh plus border fix-ups per chunk, the rest are rebuilds
+        if (run.firstMeshes > 0) {
+            passes.samples.push_back((double)(run.firstMeshes + run.borderFixups) / run.firstMeshes);
+            rebuilds.samples.push_back((double)run.meshRebuilds / run.firstMeshes);
+        }
+        passes.work = (double)run.borderFixups;
+        rebuilds.work = (double)run.firstMeshes;
+        missed.samples.push_back(run.missedPerMinute);
+        missed.work = (double)run.prefetched;
+    }
+    frame.workUnit = "chunks loaded";
+    passes.workUnit = "border fix-ups";
+    rebuilds.workUnit = "chunks meshed";
+    missed.workUnit = "chunks prefetched";
+    if (!opt.replayPath) std::remove(scriptedPath);
+
+    // the replay may change the seed, put ours back for the passes that follow
+    WorldGenerator::worldSeed = opt.seed;
+    if (!frame.samples.empty()) results.push_back(frame);
+    if (!passes.samples.empty()) results.push_back(passes);
+    if (!rebuilds.samples.empty()) results.push_back(rebuilds);
+    if (!missed.samples.empty()) results.push_back(missed);
+}
+
+/**
+ * streams the world around `position` until it has caught up (everything in
+ * range generated and meshed, physics settled) with physics, water and
+ * block ticks running, returns how long that took
+ */
+static double StreamStep(ChunkManager& world, Vector3 position, Vector3 velocity) {
+    Clock::time_point start = Clock::now();
+    for (int frame = 0; frame < 64; frame++) {
+        world.PredictMovement(position, velocity);
+        world.UpdateHeadless(position, velocity);
+        world.UpdateChunkPhysics();
+        world.UpdateFluids();
+        world.UpdateBlockTicks();
+        const ChunkStats& stats = world.GetStats();
+        if (stats.pendingGenerate == 0 && stats.pendingMesh == 0 && stats.physicsChunks == 0) break;
+    }
+    return ElapsedMs(start);
+}
+
+/**
+ * a straight run through new terrain one chunk per step, then back the same
+ * way. once the first window of chunks is behind, every chunk generated
+ * should reuse a frozen one (allocations per step over the second half of
+ * the way out). the way back thaws the cold tier instead of generating
+ */
+static void BenchStreaming(const BenchOptions& opt, std::vector<BenchResult>& results) {
+    BenchResult allocs = { "stream_chunk_allocs", "allocs/step" };
+    BenchResult fresh = { "stream_new_step", "ms/step" };
+    BenchResult revisit = { "stream_revisit_step", "ms/step" };
+    BenchResult cold = { "cold_chunk_size", "KB/chunk" };
+    int steps = 4 * (RENDER_DISTANCE + 1 + COLD_MARGIN);
+
+    for (int it = 0; it < opt.iterations; it++) {
+        ChunkManager world;
+        world.Init();
+        Vector3 position = { 0.5f * CHUNK_SIZE, (float)CHUNK_SIZE, 0.5f * CHUNK_SIZE };
+        for (int step = 0; step < steps; step++) {
+            position.x = (step + 0.5f) * CHUNK_SIZE;
+            int before = world.GetStats().chunkAllocations;
+            double ms = StreamStep(world, position, { 16.0f, 0.0f, 0.0f });
+            if (step < steps / 2) continue;
+            allocs.samples.push_back(world.GetStats().chunkAllocations - before);
+            fresh.samples.push_back(ms);
+        }
+
+        const ChunkStats& stats = world.GetStats();
+        if (stats.coldChunks > 0) cold.samples.push_back(stats.coldBytes / 1024.0 / stats.coldChunks);
+        int thawedBefore = stats.thawed;
+        for (int step = steps - 2; step >= steps / 2; step--) {
+            position.x = (step + 0.5f) * CHUNK_SIZE;
+            revisit.samples.push_back(StreamStep(world, position, { -16.0f, 0.0f, 0.0f }));
+        }
+        allocs.work = (double)world.GetStats().chunkAllocations;
+        revisit.work = (double)(world.GetStats().thawed - thawedBefore);
+        world.UnloadAll();
+    }
+    allocs.workUnit = "chunks allocated";
+    revisit.workUnit = "chunks thawed";
+    cold.work = sizeof(Chunk) / 1024.0;
+    cold.workUnit = "KB expanded";
+    results.push_back(allocs);
+    results.push_back(fresh);
+    results.push_back(revisit);
+    if (!cold.samples.empty()) results.push_back(cold);
+}
+
+/**
+ * far terrain: one finest-step tile mesh at a time, then the whole far view
+ * streamed in from scratch (one sample per Update, FAR_BUILDS_PER_FRAME tiles each)
+ */
+static void BenchFarTerrain(const BenchOptions& opt, std::vector<BenchResult>& results) {
+    BenchResult tile = { "far_tile_mesh", "ms/tile" };
+    BenchResult update = { "far_update", "ms/frame" };
+    FarMeshData data;
+
+    for (int it = 0; it < opt.iterations; it++) {
+        for (int i = 0; i < 8; i++) {
+            Clock::time_point start = Clock::now();
+            FarTerrain::BuildTileMesh(i + 2, it, FAR_MIN_STEP, data);
+            tile.samples.push_back(ElapsedMs(start));
+        }
+    }
+    tile.work = data.VertexCount() * (5 * sizeof(float) + 4);
+    tile.workUnit = "bytes per tile";
+
+    for (int it = 0; it < opt.iterations; it++) {
+        FarTerrain far;
+        Vector3 position = { 0.5f, 40.0f, 0.5f };
+        int tiles = -1;
+        while (far.GetTileCount() != tiles) {
+            tiles = far.GetTileCount();
+            Clock::time_point start = Clock::now();
+            far.Update(position);
+            update.samples.push_back(ElapsedMs(start));
+        }
+        update.work = tiles;
+        far.Unload();
+    }
+    update.workUnit = "tiles in view";
+
+    results.push_back(tile);
+    results.push_back(update);
+}
+
+static void WriteJson(FILE* f, const BenchOptions& opt, const std::vector<BenchResult>& results) {
+    fprintf(f, "{\n");
+    fprintf(f, "  \"benchmark\": \"vsandbox\",\n");
+    fprintf(f, "  \"seed\": %d,\n", opt.seed);
+    fprintf(f, "  \"radius\": %d,\n", opt.radius);
+    fprintf(f, "  \"chunk_size\": %d,\n", CHUNK_SIZE);
+    fprintf(f, "  \"iterations\": %d,\n", opt.iterations);
+    fprintf(f, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        fprintf(f, "    { \"name\": \"%s\", \"unit\": \"%s\", \"samples\": %d, \"mean\": %.4f, \"median\": %.4f, \"p95\": %.4f, \"min\": %.4f, \"max\": %.4f",
+            r.name.c_str(), r.unit.c_str(), (int)r.samples.size(), Mean(r.samples), Percentile(r.samples, 0.5),
+            Percentile(r.samples, 0.95), Percentile(r.samples, 0.0), Percentile(r.samples, 1.0));
+        if (!r.workUnit.empty()) fprintf(f, ", \"work\": %.0f, \"work_unit\": \"%s\"", r.work, r.workUnit.c_str());
+        fprintf(f, " }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n");
+    fprintf(f, "}\n");
+}
+
+static bool ParseArgs(int argc, char** argv, BenchOptions& opt) {
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--seed") && hasValue) opt.seed = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--radius") && hasValue) opt.radius = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--iterations") && hasValue) opt.iterations = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--out") && hasValue) opt.outPath = argv[++i];
+        else if (!strcmp(argv[i], "--replay") && hasValue) opt.replayPath = argv[++i];
+        else if (!strcmp(argv[i], "--verify-raycast")) opt.verifyRaycast = true;
+        else {
+            fprintf(stderr, "usage: %s [--seed N] [--radius R] [--iterations N] [--replay file.rpl] [--out file.json] [--verify-raycast]\n", argv[0]);
+            return false;
+        }
+    }
+    if (opt.radius < 1) opt.radius = 1;
+    if (opt.iterations < 1) opt.iterations = 1;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opt;
+    if (!ParseArgs(argc, argv, opt)) return 1;
+
+    WorldGenerator::worldSeed = opt.seed;
+    std::vector<BenchResult> results;
+
+    if (opt.verifyRaycast) {
+        ChunkManager world;
+        world.Init();
+        for (const ChunkCoord& c : WorldCoords(opt.radius)) world.GetOrCreateChunk(c.x, c.z);
+        bool ok = VerifyRaycast(opt, world);
+        world.UnloadAll();
+        return ok ? 0 : 1;
+    }
+
+    fprintf(stderr, "seed %d, %d chunks, %d iterations\n", opt.seed, (opt.radius * 2 + 1) * (opt.radius * 2 + 1), opt.iterations);
+
+    results.push_back(BenchGenerate(opt));
+    results.push_back(BenchPreload(opt));
+
+    // the remaining passes run against a resident world
+    ChunkManager world;
+    world.Init();
+    for (const ChunkCoord& c : WorldCoords(opt.radius)) world.GetOrCreateChunk(c.x, c.z);
+
+    results.push_back(BenchLighting(opt, world));
+    results.push_back(BenchMeshing(opt, world));
+    BenchSerialization(opt, world, results);
+    results.push_back(BenchGetBlock(opt, world));
+    BenchRegion(opt, world, results);
+    BenchRaycast(opt, world, results);
+
+    world.UnloadAll();
+
+    BenchFlight(opt, results);
+    BenchStreaming(opt, results);
+    BenchTicks(opt, results);
+    BenchEdits(opt, results);
+    BenchFlood(opt, results);
+    BenchFarTerrain(opt, results);
+
+    for (const BenchResult& r : results) {
+        fprintf(stderr, "  %-18s mean %9.4f  median %9.4f  p95 %9.4f  %s\n",
+            r.name.c_str(), Mean(r.samples), Percentile(r.samples, 0.5), Percentile(r.samples, 0.95), r.unit.c_str());
+    }
+
+    FILE* out = stdout;
+    if (opt.outPath) {
+        out = fopen(opt.outPath, "w");
+        if (!out) {
+            fprintf(stderr, "could not open %s\n", opt.outPath);
+            return 1;
+        }
+    }
+    WriteJson(out, opt, results);
+    if (out != stdout) fclose(out);
+    return 0;
+}
@@ -0,0 +1,219 @@
+#include "world/chunk_manager.h"
+#include "world/world_generator.h"
+#include "world/block_accessor.h"
+#include "player/player.h"
+#include "core/save_file.h"
+#include "core/job_system.h"
+#include <chrono>
+#include <vector>
+#include <set>
+#include <memory>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+// the world code reads these globals (normally defined by main.cpp)
+int RENDER_DISTANCE = 4;
+int CHUNK_MEMORY_MB = 512;
+
+/**
+ * generates a world ahead of time and writes it as a save the game loads
+ * (worlds/<name>.vxl), spread over every core
+ *
+ * usage: vsandbox_pregen [--seed N] [--radius R] [--center X Z] [--circle] [--out worlds/name.vxl]
+ *
+ * chunks are appended to the file a batch at a time and the chunk count is
+ * patched after every batch, so an interrupted run still loads. running the
+ * same command again resumes it, only the missing chunks are generated
+ */
+
+struct PregenOptions {
+    int seed = 12345;
+    int radius = 8;          // in chunks around the center chunk
+    int centerX = 0;         // block coordinates
+    int centerZ = 0;
+    bool circle = false;     // square by default
+    const char* outPath = "worlds/pregen.vxl";
+};
+
+// chunks generated per batch for every thread
+static const int CHUNKS_PER_THREAD = 4;
+
+typedef std::chrono::steady_clock Clock;
+
+static bool ParseArgs(int argc, char** argv, PregenOptions& opt) {
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--seed") && hasValue) opt.seed = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--radius") && hasValue) opt.radius = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--center") && i + 2 < argc) {
+            opt.centerX = atoi(argv[++i]);
+            opt.centerZ = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--circle")) opt.circle = true;
+        else if (!strcmp(argv[i], "--out") && hasValue) opt.outPath = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--seed N] [--radius R] [--center X Z] [--circle] [--out worlds/name.vxl]\n", argv[0]);
+            return false;
+        }
+    }
+    if (opt.radius < 0) opt.radius = 0;
+    return true;
+}
+
+/**
+ * header for a new save: player standing on the center column with the
+ * inventory a new game starts with
+ */
+static SaveHeader NewHeader(const PregenOptions& opt) {
+    Player player;
+    player.Init();
+
+    // the real top of the column (trees included) needs its chunk
+    int cx = ChunkOf(opt.centerX);
+    int cz = ChunkOf(opt.centerZ);
+    std::unique_ptr<Chunk> spawn = std::make_unique<Chunk>();
+    WorldGenerator::GenerateChunk(*spawn, cx, cz);
+    int top = spawn->heightMap[opt.centerX - cx * CHUNK_SIZE][opt.centerZ - cz * CHUNK_SIZE];
+
+    SaveHeader header;
+    header.seed = opt.seed;
+    header.position = { opt.centerX + 0.5f, top + 1.0f + EYE_HEIGHT, opt.centerZ + 0.5f };
+    header.inventory = player.inventory;
+    return header;
+}
+
+/**
+ * reads an earlier run back: the coordinates it already wrote and where
+ * the count and the end of the last complete record are
+ */
+static bool ReadExisting(std::fstream& file, const PregenOptions& opt, std::set<ChunkCoord>& done,
+    std::streamoff& countAt, std::streamoff& endAt) {
+    SaveHeader header;
+    const char* error = ReadSaveHeader(file, header);
+    if (error) {
+        fprintf(stderr, "%s: %s\n", opt.outPath, error);
+        return false;
+    }
+    if (header.seed != opt.seed) {
+        fprintf(stderr, "%s was generated with seed %d, not %d\n", opt.outPath, header.seed, opt.seed);
+        return false;
+    }
+    // new records are written in the current format
+    if (header.version != SAVE_VERSION) {
+        fprintf(stderr, "%s is an older save (version %d), load and save it in the game first\n", opt.outPath, header.version);
+        return false;
+    }
+    // and generated the way the rest of the world was
+    WorldGenerator::terrainVersion = header.terrain;
+
+    countAt = file.tellg();
+    size_t count = 0;
+    file.read((char*)&count, sizeof(size_t));
+
+    // a record cut short (the count is written last, so only if the disk
+    // filled up) is dropped and written again
+    std::unique_ptr<Chunk> scratch = std::make_unique<Chunk>();
+    endAt = file.tellg();
+    for (size_t i = 0; i < count; i++) {
+        ChunkCoord coord;
+        file.read((char*)&coord, sizeof(ChunkCoord));
+        scratch->fluidLevels.clear();
+        if (!ChunkManager::ReadChunkData(file, header.version, *scratch)) break;
+        done.insert(coord);
+        endAt = file.tellg();
+    }
+    file.clear();
+    return true;
+}
+
+int main(int argc, char** argv) {
+    PregenOptions opt;
+    if (!ParseArgs(argc, argv, opt)) return 1;
+    WorldGenerator::worldSeed = opt.seed;
+
+    std::set<ChunkCoord> done;
+    std::streamoff countAt = 0;
+    std::streamoff endAt = 0;
+
+    std::fstream file(opt.outPath, std::ios::in | std::ios::out | std::ios::binary);
+    if (file) {
+        if (!ReadExisting(file, opt, done, countAt, endAt)) return 1;
+        fprintf(stderr, "resuming %s, %zu chunks already there\n", opt.outPath, done.size());
+    }
+    else {
+        file.clear();
+        file.open(opt.outPath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file) {
+            fprintf(stderr, "could not create %s\n", opt.outPath);
+            return 1;
+        }
+        WriteSaveHeader(file, NewHeader(opt));
+        countAt = file.tellp();
+        size_t count = 0;
+        file.write((char*)&count, sizeof(size_t));
+        endAt = file.tellp();
+    }
+
+    // nearest first, so a cut short run still has a usable area around the spawn
+    int centerCX = ChunkOf(opt.centerX);
+    int centerCZ = ChunkOf(opt.centerZ);
+    std::vector<ChunkCoord> offsets;
+    ChunkManager::RankOffsets(opt.radius, { 0, 0, 0 }, offsets);
+    std::vector<ChunkCoord> todo;
+    for (const ChunkCoord& offset : offsets) {
+        if (opt.circle && offset.x * offset.x + offset.z * offset.z > opt.radius * opt.radius) continue;
+        ChunkCoord coord = { centerCX + offset.x, centerCZ + offset.z };
+        if (!done.count(coord)) todo.push_back(coord);
+    }
+
+    JobSystem::Init();
+    int threads = JobSystem::GetWorkerCount() + 1;
+    int batchSize = CHUNKS_PER_THREAD * threads;
+    fprintf(stderr, "seed %d, %zu chunks to generate on %d threads\n", opt.seed, todo.size(), threads);
+
+    // only used for its lighting pass, which works on one chunk at a time
+    ChunkManager lighting;
+    size_t written = done.size();
+    Clock::time_point start = Clock::now();
+
+    for (size_t first = 0; first < todo.size(); first += batchSize) {
+        size_t count = std::min(todo.size() - first, (size_t)batchSize);
+        std::vector<std::unique_ptr<Chunk>> batch(count);
+        JobSystem::ParallelFor((int)count, [&](int i) {
+            const ChunkCoord& coord = todo[first + i];
+            batch[i] = std::make_unique<Chunk>();
+            WorldGenerator::GenerateChunk(*batch[i], coord.x, coord.z);
+            lighting.ComputeChunkLighting(*batch[i]);
+        });
+
+        // records first, the count last: a run cut off here loses this batch only
+        file.seekp(endAt);
+        for (size_t i = 0; i < count; i++) {
+            file.write((char*)&todo[first + i], sizeof(ChunkCoord));
+            ChunkManager::WriteChunkData(file, *batch[i]);
+        }
+        endAt = file.tellp();
+        written += count;
+        file.seekp(countAt);
+        file.write((char*)&written, sizeof(size_t));
+        file.flush();
+        if (!file) {
+            fprintf(stderr, "\nwrite to %s failed\n", opt.outPath);
+            return 1;
+        }
+
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        fprintf(stderr, "\r%zu / %zu chunks  %.1f chunks/s", first + count, todo.size(), seconds > 0.0 ? (first + count) / seconds : 0.0);
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    fprintf(stderr, "\n");
+    printf("%s: %zu chunks (%zu new) in %.2f s, %.1f chunks/s\n", opt.outPath, written, todo.size(), seconds,
+        seconds > 0.0 ? todo.size() / seconds : 0.0);
+
+    JobSystem::Shutdown();
+    return 0;
+}